@@ -0,0 +1,121 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_BENCH_ALLOC_BACKENDS_HXX
+#define FIREBALL_BENCH_ALLOC_BACKENDS_HXX
+
+#include <allocator/bump_allocator.hxx>
+#include <allocator/specified_allocator.hxx>
+#include <allocator/task_heap.hxx>
+#include <allocator/tlsf_allocator.hxx>
+#include <commons.hxx>
+#include <new>
+
+namespace fireball {
+namespace bench {
+
+/**
+ * Arena size of every benchmarked allocator.
+ */
+inline constexpr uint32_t BENCH_ARENA_SIZE = 1024U * 1024U * 64U;
+
+/**
+ * alloc_op - One step of an allocation pattern: allocate size bytes aligned to align into slot,
+ * or free the block held by slot when size is 0.
+ */
+struct alloc_op {
+  uint32_t slot;
+  uint32_t size;
+  uint32_t align;
+};
+
+/**
+ * Backends share one shape: name, allocate/deallocate, reset to an empty arena, and begin()
+ * for footprint measurement.
+ */
+struct bump_backend {
+  struct tag {};
+  using heap = allocator::bump_allocator<BENCH_ARENA_SIZE, tag>;
+
+  static constexpr const char* name = "bump";
+
+  static void* allocate(std::size_t size, std::size_t align) noexcept {
+    return heap::instance().allocate(size, align);
+  }
+  static void deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+    heap::instance().deallocate(p, size, align);
+  }
+  static void reset() noexcept { heap::instance().reset(); }
+  static const void* begin() noexcept { return heap::instance().begin(); }
+};
+
+struct mspace_backend {
+  struct tag {};
+  using heap = allocator::specified_allocator<BENCH_ARENA_SIZE, tag>;
+
+  static constexpr const char* name = "mspace";
+
+  static void* allocate(std::size_t size, std::size_t align) noexcept {
+    return heap::instance().allocate(size, align);
+  }
+  static void deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+    heap::instance().deallocate(p, size, align);
+  }
+  static void reset() noexcept { heap::instance().reset(); }
+  static const void* begin() noexcept { return heap::instance().begin(); }
+};
+
+struct tlsf_backend {
+  struct tag {};
+  using heap = allocator::tlsf_allocator<BENCH_ARENA_SIZE, tag>;
+
+  static constexpr const char* name = "tlsf";
+
+  static void* allocate(std::size_t size, std::size_t align) noexcept {
+    return heap::instance().allocate(size, align);
+  }
+  static void deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+    heap::instance().deallocate(p, size, align);
+  }
+  static void reset() noexcept {
+    // every pattern frees all of its blocks.
+  }
+  static const void* begin() noexcept { return heap::instance().begin(); }
+};
+
+/**
+ * Global operator new/delete with a task heap switched in, as a COOS task sees them.
+ */
+struct new_backend {
+  struct tag {};
+  using heap = allocator::specified_allocator<BENCH_ARENA_SIZE, tag>;
+
+  static constexpr const char* name = "new";
+
+  static void* allocate(std::size_t size, std::size_t align) noexcept {
+    if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      return ::operator new(size, std::nothrow);
+    }
+    return ::operator new(size, std::align_val_t(align), std::nothrow);
+  }
+  static void deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+    if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(p, size);
+    } else {
+      ::operator delete(p, size, std::align_val_t(align));
+    }
+  }
+  static void reset() noexcept {
+    static allocator::task_heap task = allocator::task_heap::of(heap::instance());
+    heap::instance().reset();
+    allocator::switch_task_heap(&task);
+  }
+  static const void* begin() noexcept { return heap::instance().begin(); }
+};
+
+} // namespace bench
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_BENCH_ALLOC_BACKENDS_HXX
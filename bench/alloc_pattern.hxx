@@ -0,0 +1,139 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_BENCH_ALLOC_PATTERN_HXX
+#define FIREBALL_BENCH_ALLOC_PATTERN_HXX
+
+#include "alloc_backends.hxx"
+#include "bench_common.hxx"
+#include <cstddef>
+
+namespace fireball {
+namespace bench {
+
+inline constexpr std::size_t MAX_OPS = 1U << 18U;
+inline constexpr std::size_t MAX_SLOTS = 4096U;
+
+/**
+ * alloc_pattern - Fixed list of alloc_op, synthetic or converted from a recorded trace.
+ */
+struct alloc_pattern {
+  const char* name;
+  std::size_t count;
+  std::array<alloc_op, MAX_OPS> ops;
+  std::array<bool, MAX_SLOTS> live;
+
+  void begin(const char* pattern_name) noexcept {
+    name = pattern_name;
+    count = 0U;
+    live.fill(false);
+  }
+
+  /**
+   * True when there is no room left for another round plus the final frees.
+   */
+  bool full() const noexcept { return count + MAX_SLOTS >= MAX_OPS; }
+
+  void alloc(uint32_t slot, uint32_t size,
+             uint32_t align = static_cast<uint32_t>(alignof(std::max_align_t))) noexcept {
+    ops[count++] = alloc_op{slot, size, align};
+    live[slot] = true;
+  }
+
+  void free(uint32_t slot) noexcept {
+    ops[count++] = alloc_op{slot, 0U, 0U};
+    live[slot] = false;
+  }
+
+  /**
+   * Free every block still live so that each replay leaves the backend empty.
+   */
+  void end() noexcept {
+    for (uint32_t slot = 0U; slot < MAX_SLOTS; ++slot) {
+      if (live[slot]) {
+        free(slot);
+      }
+    }
+  }
+};
+
+/**
+ * pattern_replayer - Replays an alloc_pattern against a backend and prints one result row.
+ *
+ * Reports throughput, p50/p99/max latency per operation in cycles, and the peak footprint,
+ * i.e. the highest arena offset touched by a live block, which is the partition size the
+ * pattern needs.
+ */
+class pattern_replayer {
+public:
+  static void print_header() noexcept {
+    std::printf("%-12s %-8s %8s %10s %8s %8s %10s %12s %6s\n", "pattern", "backend", "ops",
+                "Mops/s", "p50", "p99", "max", "peak_bytes", "fail");
+  }
+
+  /**
+   * Replay the pattern twice and report the second run, so first-touch page faults of the host
+   * do not show up as allocator latency.
+   */
+  template <typename Backend> void run(const alloc_pattern& pattern) noexcept {
+    replay<Backend>(pattern);
+    const auto result = replay<Backend>(pattern);
+    const auto ops = latencies_.size();
+    const auto mops = static_cast<double>(ops) * 1000.0 / static_cast<double>(result.elapsed_ns);
+    const auto p50 = latencies_.percentile(50.0);
+    const auto p99 = latencies_.percentile(99.0);
+    const auto max = latencies_.percentile(100.0);
+    std::printf("%-12s %-8s %8zu %10.2f %8u %8u %10u %12zu %6zu\n", pattern.name, Backend::name,
+                ops, mops, p50, p99, max, static_cast<std::size_t>(result.peak), result.failures);
+  }
+
+private:
+  struct replay_result {
+    uint64_t elapsed_ns;
+    uintptr_t peak;
+    std::size_t failures;
+  };
+
+  template <typename Backend> replay_result replay(const alloc_pattern& pattern) noexcept {
+    Backend::reset();
+    latencies_.clear();
+    const auto base = reinterpret_cast<uintptr_t>(Backend::begin());
+    replay_result ret = {0U, 0U, 0U};
+    const auto start = now_ns();
+    for (std::size_t i = 0U; i < pattern.count; ++i) {
+      const auto op = pattern.ops[i];
+      if (op.size != 0U) {
+        const auto t0 = cycles();
+        auto p = Backend::allocate(op.size, op.align);
+        latencies_.record(cycles() - t0);
+        blocks_[op.slot] = p;
+        sizes_[op.slot] = op.size;
+        aligns_[op.slot] = op.align;
+        if (p == nullptr) {
+          ++ret.failures;
+        } else {
+          ret.peak = std::max(ret.peak, reinterpret_cast<uintptr_t>(p) + op.size - base);
+        }
+      } else if (blocks_[op.slot] != nullptr) {
+        const auto t0 = cycles();
+        Backend::deallocate(blocks_[op.slot], sizes_[op.slot], aligns_[op.slot]);
+        latencies_.record(cycles() - t0);
+        blocks_[op.slot] = nullptr;
+      }
+    }
+    ret.elapsed_ns = now_ns() - start;
+    return ret;
+  }
+
+  latency_recorder<MAX_OPS> latencies_;
+  std::array<void*, MAX_SLOTS> blocks_;
+  std::array<uint32_t, MAX_SLOTS> sizes_;
+  std::array<uint32_t, MAX_SLOTS> aligns_;
+}; // class pattern_replayer
+
+} // namespace bench
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_BENCH_ALLOC_PATTERN_HXX
@@ -0,0 +1,232 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * alloc_replay.cxx - Replays a recorded allocation trace against the allocator backends.
+ *
+ * Usage: alloc_replay <trace> [backend...]
+ *
+ * The trace is a dump of alloc_trace_dump() taken on the target or on the host. Its records
+ * are converted into an alloc_pattern: every live address is mapped to a slot, frees of blocks
+ * allocated before recording started and failed allocations are skipped, and blocks still live
+ * at the end of the trace are freed. The pattern is then replayed like the synthetic ones of
+ * allocator_bench against the named backends (bump, mspace, tlsf, new), or all of them.
+ *
+ * Like the benchmark, the tool never allocates: the trace is read into a static array.
+ */
+#include "alloc_pattern.hxx"
+#include <allocator/alloc_trace.hxx>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace fireball::bench;
+using fireball::allocator::trace_header;
+using fireball::allocator::trace_op;
+using fireball::allocator::trace_record;
+
+std::array<trace_record, MAX_OPS> records;
+alloc_pattern current;
+pattern_replayer replayer;
+
+/**
+ * slot_map - Open addressing map from a traced address to its slot, with a stack of free slots.
+ */
+class slot_map {
+public:
+  static constexpr uint32_t NONE = ~0U;
+
+  slot_map() noexcept : keys_(), slots_(), used_(), free_slots_(), free_count_(MAX_SLOTS) {
+    for (uint32_t i = 0U; i < MAX_SLOTS; ++i) {
+      free_slots_[i] = static_cast<uint32_t>(MAX_SLOTS) - 1U - i;
+    }
+  }
+
+  uint32_t find(uint32_t ptr) const noexcept {
+    for (auto i = hash(ptr); used_[i]; i = (i + 1U) & MASK) {
+      if (keys_[i] == ptr) {
+        return slots_[i];
+      }
+    }
+    return NONE;
+  }
+
+  /**
+   * Assign a free slot to ptr, or return NONE when all slots are live.
+   */
+  uint32_t insert(uint32_t ptr) noexcept {
+    if (free_count_ == 0U) {
+      return NONE;
+    }
+    auto i = hash(ptr);
+    while (used_[i]) {
+      i = (i + 1U) & MASK;
+    }
+    const auto slot = free_slots_[--free_count_];
+    keys_[i] = ptr;
+    slots_[i] = slot;
+    used_[i] = true;
+    return slot;
+  }
+
+  /**
+   * Remove ptr and shift the following entries of its probe run back into place.
+   */
+  void erase(uint32_t ptr) noexcept {
+    auto i = hash(ptr);
+    while (used_[i] && keys_[i] != ptr) {
+      i = (i + 1U) & MASK;
+    }
+    if (!used_[i]) {
+      return;
+    }
+    free_slots_[free_count_++] = slots_[i];
+    used_[i] = false;
+    for (auto j = (i + 1U) & MASK; used_[j]; j = (j + 1U) & MASK) {
+      const auto home = hash(keys_[j]);
+      // move j into the hole at i unless its home lies cyclically in (i, j].
+      if (((j - home) & MASK) >= ((j - i) & MASK)) {
+        keys_[i] = keys_[j];
+        slots_[i] = slots_[j];
+        used_[i] = true;
+        used_[j] = false;
+        i = j;
+      }
+    }
+  }
+
+private:
+  static constexpr uint32_t TABLE_SIZE = static_cast<uint32_t>(MAX_SLOTS) * 2U;
+  static constexpr uint32_t MASK = TABLE_SIZE - 1U;
+
+  static uint32_t hash(uint32_t ptr) noexcept { return ((ptr >> 4U) * 0x9E3779B1U) >> 19U; }
+
+  static_assert(TABLE_SIZE == 1U << 13U, "hash() yields 13 bits");
+
+  std::array<uint32_t, TABLE_SIZE> keys_;
+  std::array<uint32_t, TABLE_SIZE> slots_;
+  std::array<bool, TABLE_SIZE> used_;
+  std::array<uint32_t, MAX_SLOTS> free_slots_;
+  std::size_t free_count_;
+}; // class slot_map
+
+slot_map slots;
+
+/**
+ * Read the trace into records. Returns the number of records, or 0 on error.
+ */
+std::size_t load(const char* path) noexcept {
+  const auto fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    std::fprintf(stderr, "alloc_replay: cannot open %s\n", path);
+    return 0U;
+  }
+  auto read_all = [fd](void* dst, std::size_t size) {
+    auto p = static_cast<uint8_t*>(dst);
+    std::size_t done = 0U;
+    while (done < size) {
+      const auto n = ::read(fd, p + done, size - done);
+      if (n <= 0) {
+        break;
+      }
+      done += static_cast<std::size_t>(n);
+    }
+    return done;
+  };
+  trace_header header = {};
+  std::size_t count = 0U;
+  if (read_all(&header, sizeof(header)) != sizeof(header) ||
+      header.magic != trace_header::MAGIC || header.version != trace_header::VERSION ||
+      header.record_size != sizeof(trace_record)) {
+    std::fprintf(stderr, "alloc_replay: %s is not an allocation trace\n", path);
+  } else {
+    count = std::min<std::size_t>(header.count, records.size());
+    count = read_all(records.data(), count * sizeof(trace_record)) / sizeof(trace_record);
+    std::printf("# %s: %u records, %u dropped while recording, %zu loaded\n", path, header.count,
+                header.dropped, count);
+  }
+  ::close(fd);
+  return count;
+}
+
+/**
+ * Convert count records into the current pattern.
+ */
+void convert(std::size_t count) noexcept {
+  std::size_t skipped = 0U;
+  current.begin("trace");
+  for (std::size_t i = 0U; i < count && !current.full(); ++i) {
+    const auto& r = records[i];
+    if (r.op == trace_op::alloc) {
+      // a free that was not recorded (ring overrun); forget the stale block first.
+      if (const auto stale = slots.find(r.ptr); stale != slot_map::NONE) {
+        current.free(stale);
+        slots.erase(r.ptr);
+      }
+      const auto slot = slots.insert(r.ptr);
+      if (slot == slot_map::NONE) {
+        ++skipped;
+        continue;
+      }
+      current.alloc(slot, r.size == 0U ? 1U : r.size, 1U << r.align_log2);
+    } else if (r.op == trace_op::free) {
+      const auto slot = slots.find(r.ptr);
+      if (slot == slot_map::NONE) {
+        ++skipped;
+        continue;
+      }
+      current.free(slot);
+      slots.erase(r.ptr);
+    } else {
+      ++skipped;
+    }
+  }
+  current.end();
+  std::printf("# %zu ops replayed, %zu records skipped\n", current.count, skipped);
+}
+
+bool selected(int argc, char const** argv, const char* name) noexcept {
+  if (argc <= 2) {
+    return true;
+  }
+  for (int i = 2; i < argc; ++i) {
+    if (std::strcmp(argv[i], name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Backend> void run_if_selected(int argc, char const** argv) noexcept {
+  if (selected(argc, argv, Backend::name)) {
+    replayer.run<Backend>(current);
+  }
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main(int argc, char const** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: alloc_replay <trace> [bump|mspace|tlsf|new ...]\n");
+    return 1;
+  }
+  const auto count = load(argv[1]);
+  if (count == 0U) {
+    return 1;
+  }
+  convert(count);
+  pattern_replayer::print_header();
+  run_if_selected<bump_backend>(argc, argv);
+  run_if_selected<mspace_backend>(argc, argv);
+  run_if_selected<tlsf_backend>(argc, argv);
+  run_if_selected<new_backend>(argc, argv);
+  return 0;
+}
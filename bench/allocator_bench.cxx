@@ -0,0 +1,135 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * allocator_bench.cxx - Allocator benchmark over synthetic allocation patterns.
+ *
+ * Every pattern is generated once into a fixed op list and replayed against each backend
+ * (bump_allocator, specified_allocator, tlsf_allocator and the global operator new path).
+ * For each pair it reports throughput, p50/p99/max latency per operation in cycles, and the
+ * peak footprint, i.e. the highest arena offset touched by a live block, which is the partition
+ * size the pattern needs.
+ *
+ * The benchmark itself never allocates: ops, slots and samples live in static arrays.
+ */
+#include "alloc_pattern.hxx"
+
+namespace {
+
+using namespace fireball::bench;
+
+alloc_pattern current;
+pattern_replayer replayer;
+
+/**
+ * Log-uniform size in [lo, hi] (more small blocks than large ones, as in real programs).
+ */
+uint32_t log_size(xorshift32& rng, uint32_t lo, uint32_t hi) noexcept {
+  const auto bits = rng.range(static_cast<uint32_t>(std::bit_width(lo)),
+                              static_cast<uint32_t>(std::bit_width(hi)));
+  return std::clamp(rng.range(1U << (bits - 1U), (1U << bits) - 1U), lo, hi);
+}
+
+void make_lifo() noexcept {
+  xorshift32 rng{1U};
+  current.begin("lifo");
+  while (!current.full()) {
+    const auto depth = rng.range(1U, 64U);
+    for (uint32_t i = 0U; i < depth; ++i) {
+      current.alloc(i, log_size(rng, 16U, 512U));
+    }
+    for (auto i = depth; i-- > 0U;) {
+      current.free(i);
+    }
+  }
+  current.end();
+}
+
+void make_fifo() noexcept {
+  xorshift32 rng{2U};
+  current.begin("fifo");
+  for (uint32_t i = 0U; !current.full(); ++i) {
+    const auto slot = i % 256U;
+    if (current.live[slot]) {
+      current.free(slot);
+    }
+    current.alloc(slot, log_size(rng, 16U, 512U));
+  }
+  current.end();
+}
+
+void make_random() noexcept {
+  xorshift32 rng{3U};
+  current.begin("random");
+  while (!current.full()) {
+    const auto slot = rng.range(0U, 1023U);
+    if (current.live[slot]) {
+      current.free(slot);
+    } else {
+      current.alloc(slot, log_size(rng, 8U, 4096U));
+    }
+  }
+  current.end();
+}
+
+/**
+ * IPC key-value messages: mostly 16-64 byte records with some larger payloads, short-lived and
+ * delivered out of order within a window of 64 in-flight messages.
+ */
+void make_ipc_churn() noexcept {
+  xorshift32 rng{4U};
+  current.begin("ipc_churn");
+  while (!current.full()) {
+    const auto slot = rng.range(0U, 63U);
+    if (current.live[slot]) {
+      current.free(slot);
+    }
+    current.alloc(slot, rng.range(0U, 9U) == 0U ? rng.range(128U, 512U) : rng.range(16U, 64U));
+  }
+  current.end();
+}
+
+/**
+ * wasm module load: the index tables of a module are allocated in section order and released
+ * together when the module is unloaded, then the next module is loaded.
+ */
+void make_module_load() noexcept {
+  xorshift32 rng{5U};
+  current.begin("module_load");
+  while (!current.full()) {
+    const auto tables = rng.range(32U, 256U);
+    for (uint32_t i = 0U; i < tables; ++i) {
+      current.alloc(i, log_size(rng, 8U, 2048U));
+    }
+    for (uint32_t i = 0U; i < tables; ++i) {
+      current.free(i);
+    }
+  }
+  current.end();
+}
+
+void run_all() noexcept {
+  replayer.run<bump_backend>(current);
+  replayer.run<mspace_backend>(current);
+  replayer.run<tlsf_backend>(current);
+  replayer.run<new_backend>(current);
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  pattern_replayer::print_header();
+  void (*const patterns[])() = {make_lifo, make_fifo, make_random, make_ipc_churn,
+                                make_module_load};
+  for (auto make : patterns) {
+    make();
+    run_all();
+  }
+  return 0;
+}
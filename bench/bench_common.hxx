@@ -0,0 +1,108 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_BENCH_BENCH_COMMON_HXX
+#define FIREBALL_BENCH_BENCH_COMMON_HXX
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <commons.hxx>
+#include <cstdio>
+#include <utils/cycle_counter.hxx>
+
+namespace fireball {
+namespace bench {
+
+/**
+ * Cycle counter of the host, see utils::cycle_counter().
+ */
+inline uint64_t cycles() noexcept { return utils::cycle_counter(); }
+
+/**
+ * Keep the optimizer from removing a computation whose result is otherwise unused.
+ */
+template <typename T> inline void do_not_optimize(const T& value) noexcept {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * latency_recorder - Per-operation latencies in cycles, kept in a fixed-size buffer.
+ *
+ * Samples beyond Capacity are dropped; the benchmark sizes its runs to fit.
+ */
+template <std::size_t Capacity> class latency_recorder {
+public:
+  void clear() noexcept { size_ = 0U; }
+
+  void record(uint64_t c) noexcept {
+    if (size_ < Capacity) {
+      samples_[size_++] = static_cast<uint32_t>(std::min<uint64_t>(c, UINT32_MAX));
+    }
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  /**
+   * Sample at the given percentile (0-100); sorts the samples.
+   */
+  uint32_t percentile(double pct) noexcept {
+    if (size_ == 0U) {
+      return 0U;
+    }
+    std::sort(samples_.begin(), samples_.begin() + size_);
+    const auto idx = static_cast<std::size_t>(pct / 100.0 * static_cast<double>(size_ - 1U));
+    return samples_[idx];
+  }
+
+private:
+  std::array<uint32_t, Capacity> samples_;
+  std::size_t size_ = 0U;
+}; // class latency_recorder
+
+/**
+ * Wall clock in nanoseconds for throughput figures.
+ */
+inline uint64_t now_ns() noexcept {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+/**
+ * Run body(i) for i in [0, ops) and return the mean time per call in nanoseconds. One untimed
+ * round first warms caches and the allocators under test.
+ */
+template <typename F> double ns_per_op(std::size_t ops, F&& body) noexcept {
+  for (std::size_t i = 0U; i < ops; ++i) {
+    body(i);
+  }
+  const auto start = now_ns();
+  for (std::size_t i = 0U; i < ops; ++i) {
+    body(i);
+  }
+  return static_cast<double>(now_ns() - start) / static_cast<double>(ops);
+}
+
+/**
+ * xorshift32 - Deterministic pseudo random numbers for synthetic workloads.
+ */
+struct xorshift32 {
+  uint32_t state;
+
+  uint32_t next() noexcept {
+    state ^= state << 13U;
+    state ^= state >> 17U;
+    state ^= state << 5U;
+    return state;
+  }
+
+  uint32_t range(uint32_t lo, uint32_t hi) noexcept { return lo + next() % (hi - lo + 1U); }
+};
+
+} // namespace bench
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_BENCH_BENCH_COMMON_HXX
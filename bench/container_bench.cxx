@@ -0,0 +1,161 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * container_bench.cxx - fireball containers against their std equivalents.
+ *
+ * Each case runs the same workload on a fireball container and on the std container it
+ * replaces and prints the time per operation. The std containers are given the same
+ * specified_allocator arena through std::pmr, so the comparison is about the data structure
+ * and not about the heap.
+ *
+ *   push      - fill a vector of 64 elements and clear it
+ *   grow      - fill a vector of 16384 elements from empty, then destroy it
+ *   lookup    - find random keys in a map of 100 entries
+ *   churn     - erase and re-insert random keys of a map of 100 entries
+ */
+#include "bench_common.hxx"
+#include <allocator/bump_allocator.hxx>
+#include <allocator/specified_allocator.hxx>
+#include <container/flat_map.hxx>
+#include <container/growable_vector.hxx>
+#include <container/inplace_vector.hxx>
+#include <map>
+#include <vector>
+
+namespace {
+
+using namespace fireball;
+using namespace fireball::bench;
+
+constexpr uint32_t ARENA_SIZE = 16U * 1024U * 1024U;
+constexpr std::size_t OPS = 20000U;
+constexpr std::size_t MAP_SIZE = 100U;
+constexpr std::size_t GROW_SIZE = 16384U;
+
+struct spec_tag {};
+struct bump_tag {};
+using spec_heap = allocator::specified_allocator<ARENA_SIZE, spec_tag>;
+using bump_heap = allocator::bump_allocator<ARENA_SIZE, bump_tag>;
+
+void print_row(const char* name, const char* fireball_name, double fireball_ns,
+               const char* std_name, double std_ns) noexcept {
+  std::printf("%-8s %-28s %10.1f %-28s %10.1f %7.2fx\n", name, fireball_name, fireball_ns,
+              std_name, std_ns, std_ns / fireball_ns);
+}
+
+void bench_push() noexcept {
+  container::inplace_vector<uint32_t, 64U> iv;
+  const auto iv_ns = ns_per_op(OPS, [&](std::size_t) {
+    for (uint32_t i = 0U; i < 64U; ++i) {
+      iv.try_push_back(i);
+    }
+    do_not_optimize(iv.data());
+    iv.clear();
+  });
+  std::pmr::vector<uint32_t> sv(&spec_heap::instance());
+  const auto sv_ns = ns_per_op(OPS, [&](std::size_t) {
+    for (uint32_t i = 0U; i < 64U; ++i) {
+      sv.push_back(i);
+    }
+    do_not_optimize(sv.data());
+    sv.clear();
+  });
+  print_row("push", "inplace_vector", iv_ns, "std::pmr::vector", sv_ns);
+}
+
+/**
+ * The bump arena is rewound after every vector, as a component would on exit.
+ */
+void rewind(std::pmr::memory_resource* resource) noexcept {
+  if (resource == &bump_heap::instance()) {
+    bump_heap::instance().reset();
+  }
+}
+
+template <typename Alloc> double grow_fireball() noexcept {
+  return ns_per_op(OPS / 100U, [](std::size_t) {
+    {
+      container::growable_vector<uint32_t, Alloc> v;
+      for (uint32_t i = 0U; i < GROW_SIZE; ++i) {
+        v.try_push_back(i);
+      }
+      do_not_optimize(v.data());
+    }
+    rewind(&Alloc::resource_type::instance());
+  });
+}
+
+double grow_std(std::pmr::memory_resource* resource) noexcept {
+  return ns_per_op(OPS / 100U, [resource](std::size_t) {
+    {
+      std::pmr::vector<uint32_t> v(resource);
+      for (uint32_t i = 0U; i < GROW_SIZE; ++i) {
+        v.push_back(i);
+      }
+      do_not_optimize(v.data());
+    }
+    rewind(resource);
+  });
+}
+
+void bench_grow() noexcept {
+  const auto spec_ns = grow_fireball<spec_heap::allocator<uint32_t>>();
+  const auto spec_std_ns = grow_std(&spec_heap::instance());
+  print_row("grow", "growable_vector (mspace)", spec_ns, "std::pmr::vector (mspace)", spec_std_ns);
+  const auto bump_ns = grow_fireball<bump_heap::allocator<uint32_t>>();
+  const auto bump_std_ns = grow_std(&bump_heap::instance());
+  print_row("grow", "growable_vector (bump)", bump_ns, "std::pmr::vector (bump)", bump_std_ns);
+}
+
+void bench_map() noexcept {
+  container::flat_map<uint32_t, uint32_t, MAP_SIZE> fm;
+  std::pmr::map<uint32_t, uint32_t> sm(&spec_heap::instance());
+  xorshift32 rng{1U};
+  for (uint32_t i = 0U; i < MAP_SIZE; ++i) {
+    const auto key = rng.next();
+    fm.insert_or_assign(key, i);
+    sm[key] = i;
+  }
+  std::array<uint32_t, MAP_SIZE> keys;
+  for (std::size_t i = 0U; i < MAP_SIZE; ++i) {
+    keys[i] = fm.at_rank(i).first;
+  }
+  // visit the keys in a scrambled order so the branch predictor cannot learn the path.
+  auto key_of = [&keys](std::size_t i) { return keys[(i * 37U) % MAP_SIZE]; };
+
+  const auto fm_find =
+      ns_per_op(OPS * 10U, [&](std::size_t i) { do_not_optimize(fm.find(key_of(i))); });
+  const auto sm_find =
+      ns_per_op(OPS * 10U, [&](std::size_t i) { do_not_optimize(sm.find(key_of(i))); });
+  print_row("lookup", "flat_map<100>", fm_find, "std::pmr::map", sm_find);
+
+  const auto fm_churn = ns_per_op(OPS * 10U, [&](std::size_t i) {
+    const auto key = key_of(i);
+    fm.erase(key);
+    fm.insert_or_assign(key, static_cast<uint32_t>(i));
+  });
+  const auto sm_churn = ns_per_op(OPS * 10U, [&](std::size_t i) {
+    const auto key = key_of(i);
+    sm.erase(key);
+    sm[key] = static_cast<uint32_t>(i);
+  });
+  print_row("churn", "flat_map<100>", fm_churn, "std::pmr::map", sm_churn);
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  std::printf("%-8s %-28s %10s %-28s %10s %8s\n", "case", "fireball", "ns/op", "std", "ns/op",
+              "speedup");
+  bench_push();
+  bench_grow();
+  bench_map();
+  return 0;
+}
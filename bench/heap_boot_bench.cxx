@@ -0,0 +1,87 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * heap_boot_bench.cxx - Cost of bringing up the partition heaps and of reaching them.
+ *
+ * Boot and first allocation can only be measured once per process, so they are single
+ * samples in cycles; run the benchmark a few times to see their spread.
+ *
+ *   boot      - init_partition_heaps(), which lays out every partition heap
+ *   first     - first allocation from each partition heap after boot
+ *   new       - operator new/delete of 32 bytes with the guest heap switched in, as a COOS
+ *               task sees them
+ *   pmr       - allocate/deallocate of 32 bytes through std::pmr::memory_resource
+ *   static    - allocate/deallocate of 32 bytes through static_allocator
+ */
+#include "bench_common.hxx"
+#include <allocator/partition_heaps.hxx>
+#include <allocator/task_heap.hxx>
+#include <new>
+
+namespace {
+
+using namespace fireball;
+using namespace fireball::bench;
+
+constexpr std::size_t OPS = 1000000U;
+constexpr std::size_t BLOCK = 32U;
+
+template <typename Heap> void print_first(const char* name) noexcept {
+  const auto start = cycles();
+  auto p = Heap::instance().allocate(BLOCK);
+  const auto elapsed = cycles() - start;
+  do_not_optimize(p);
+  std::printf("%-8s %-24s %12llu cycles\n", "first", name,
+              static_cast<unsigned long long>(elapsed));
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  const auto start = cycles();
+  allocator::init_partition_heaps();
+  const auto boot = cycles() - start;
+  std::printf("%-8s %-24s %12llu cycles\n", "boot", "init_partition_heaps",
+              static_cast<unsigned long long>(boot));
+
+  print_first<allocator::coos_kernel_heap>("coos_kernel_heap");
+  print_first<allocator::wasm_runtime_heap>("wasm_runtime_heap");
+  print_first<allocator::subsystem_heap>("subsystem_heap");
+  print_first<allocator::service_heap>("service_heap");
+  print_first<allocator::guest_heap>("guest_heap");
+
+  auto task = allocator::task_heap::of(allocator::guest_heap::instance());
+  allocator::switch_task_heap(&task);
+  const auto new_ns = ns_per_op(OPS, [](std::size_t) {
+    auto p = ::operator new(BLOCK);
+    do_not_optimize(p);
+    ::operator delete(p, BLOCK);
+  });
+  allocator::switch_task_heap(nullptr);
+  std::printf("%-8s %-24s %12.1f ns\n", "new", "guest_heap", new_ns);
+
+  std::pmr::memory_resource* resource = &allocator::subsystem_heap::instance();
+  do_not_optimize(resource);
+  const auto pmr_ns = ns_per_op(OPS, [resource](std::size_t) {
+    auto p = resource->allocate(BLOCK);
+    do_not_optimize(p);
+    resource->deallocate(p, BLOCK);
+  });
+  std::printf("%-8s %-24s %12.1f ns\n", "pmr", "subsystem_heap", pmr_ns);
+
+  allocator::subsystem_heap::static_allocator<std::array<uint8_t, BLOCK>> direct;
+  const auto static_ns = ns_per_op(OPS, [&direct](std::size_t) {
+    auto p = direct.allocate(1U);
+    do_not_optimize(p);
+    direct.deallocate(p, 1U);
+  });
+  std::printf("%-8s %-24s %12.1f ns\n", "static", "subsystem_heap", static_ns);
+  return 0;
+}
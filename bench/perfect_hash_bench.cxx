@@ -0,0 +1,177 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * perfect_hash_bench.cxx - constexpr perfect hash against a sorted array.
+ *
+ * Both tables are built at compile time from the same keys and live in read-only data; the
+ * sorted array is searched with std::lower_bound. Keys are looked up in a scrambled order so
+ * the branch predictor cannot learn the search path, and one case mixes in keys that are not
+ * in the table.
+ *
+ *   import    - 48 WASI import names (std::string_view keys)
+ *   id        - 256 sparse 32-bit ids
+ *   miss      - 256 sparse ids, half of the lookups missing
+ */
+#include "bench_common.hxx"
+#include <algorithm>
+#include <string_view>
+#include <utils/perfect_hash.hxx>
+
+namespace {
+
+using namespace fireball;
+using namespace fireball::bench;
+
+constexpr std::size_t OPS = 1000000U;
+constexpr std::size_t ID_COUNT = 256U;
+
+constexpr std::pair<std::string_view, uint16_t> IMPORTS[] = {
+    {"args_get", 0U},
+    {"args_sizes_get", 1U},
+    {"clock_res_get", 2U},
+    {"clock_time_get", 3U},
+    {"environ_get", 4U},
+    {"environ_sizes_get", 5U},
+    {"fd_advise", 6U},
+    {"fd_allocate", 7U},
+    {"fd_close", 8U},
+    {"fd_datasync", 9U},
+    {"fd_fdstat_get", 10U},
+    {"fd_fdstat_set_flags", 11U},
+    {"fd_fdstat_set_rights", 12U},
+    {"fd_filestat_get", 13U},
+    {"fd_filestat_set_size", 14U},
+    {"fd_filestat_set_times", 15U},
+    {"fd_pread", 16U},
+    {"fd_prestat_dir_name", 17U},
+    {"fd_prestat_get", 18U},
+    {"fd_pwrite", 19U},
+    {"fd_read", 20U},
+    {"fd_readdir", 21U},
+    {"fd_renumber", 22U},
+    {"fd_seek", 23U},
+    {"fd_sync", 24U},
+    {"fd_tell", 25U},
+    {"fd_write", 26U},
+    {"path_create_directory", 27U},
+    {"path_filestat_get", 28U},
+    {"path_filestat_set_times", 29U},
+    {"path_link", 30U},
+    {"path_open", 31U},
+    {"path_readlink", 32U},
+    {"path_remove_directory", 33U},
+    {"path_rename", 34U},
+    {"path_symlink", 35U},
+    {"path_unlink_file", 36U},
+    {"poll_oneoff", 37U},
+    {"proc_exit", 38U},
+    {"proc_raise", 39U},
+    {"random_get", 40U},
+    {"sched_yield", 41U},
+    {"sock_accept", 42U},
+    {"sock_recv", 43U},
+    {"sock_send", 44U},
+    {"sock_shutdown", 45U},
+    {"thread_spawn", 46U},
+    {"thread_exit", 47U},
+};
+
+constexpr std::size_t IMPORT_COUNT = std::size(IMPORTS);
+
+constexpr auto IMPORT_HASH = utils::make_perfect_hash(IMPORTS);
+static_assert(IMPORT_HASH.valid());
+
+constexpr auto IMPORT_SORTED = [] {
+  std::array<std::pair<std::string_view, uint16_t>, IMPORT_COUNT> ret = {};
+  std::copy(std::begin(IMPORTS), std::end(IMPORTS), ret.begin());
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}();
+
+/**
+ * Sparse ids spread over the whole 32-bit range, value = position.
+ */
+constexpr std::array<std::pair<uint32_t, uint16_t>, ID_COUNT> IDS = [] {
+  std::array<std::pair<uint32_t, uint16_t>, ID_COUNT> ret = {};
+  uint32_t x = 0x2545F491U;
+  for (std::size_t i = 0U; i < ID_COUNT; ++i) {
+    x ^= x << 13U;
+    x ^= x >> 17U;
+    x ^= x << 5U;
+    ret[i] = {x, static_cast<uint16_t>(i)};
+  }
+  return ret;
+}();
+constexpr utils::perfect_hash_map<uint32_t, uint16_t, ID_COUNT> ID_HASH(IDS);
+static_assert(ID_HASH.valid());
+
+constexpr auto ID_SORTED = [] {
+  auto ret = IDS;
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}();
+
+template <typename Key, typename Value, std::size_t N>
+const Value* sorted_find(const std::array<std::pair<Key, Value>, N>& table,
+                         const Key& key) noexcept {
+  const auto pos = std::lower_bound(table.begin(), table.end(), key,
+                                    [](const auto& e, const Key& k) { return e.first < k; });
+  return pos != table.end() && pos->first == key ? &pos->second : nullptr;
+}
+
+void print_row(const char* name, double hash_ns, double sorted_ns) noexcept {
+  std::printf("%-8s %14.2f %14.2f %7.2fx\n", name, hash_ns, sorted_ns, sorted_ns / hash_ns);
+}
+
+void bench_import() noexcept {
+  auto key_of = [](std::size_t i) { return IMPORTS[(i * 31U) % IMPORT_COUNT].first; };
+  const auto hash_ns =
+      ns_per_op(OPS, [&](std::size_t i) { do_not_optimize(IMPORT_HASH.find(key_of(i))); });
+  const auto sorted_ns = ns_per_op(
+      OPS, [&](std::size_t i) { do_not_optimize(sorted_find(IMPORT_SORTED, key_of(i))); });
+  print_row("import", hash_ns, sorted_ns);
+}
+
+void bench_id() noexcept {
+  auto key_of = [](std::size_t i) { return IDS[(i * 97U) % ID_COUNT].first; };
+  const auto hash_ns =
+      ns_per_op(OPS, [&](std::size_t i) { do_not_optimize(ID_HASH.find(key_of(i))); });
+  const auto sorted_ns =
+      ns_per_op(OPS, [&](std::size_t i) { do_not_optimize(sorted_find(ID_SORTED, key_of(i))); });
+  print_row("id", hash_ns, sorted_ns);
+}
+
+void bench_miss() noexcept {
+  // odd lookups flip the low bit, which almost never yields another id of the table.
+  auto key_of = [](std::size_t i) {
+    return IDS[(i * 97U) % ID_COUNT].first ^ static_cast<uint32_t>(i & 1U);
+  };
+  const auto hash_ns =
+      ns_per_op(OPS, [&](std::size_t i) { do_not_optimize(ID_HASH.find(key_of(i))); });
+  const auto sorted_ns =
+      ns_per_op(OPS, [&](std::size_t i) { do_not_optimize(sorted_find(ID_SORTED, key_of(i))); });
+  print_row("miss", hash_ns, sorted_ns);
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  for (const auto& [key, value] : IMPORTS) {
+    if (IMPORT_HASH.find(key) == nullptr || *IMPORT_HASH.find(key) != value) {
+      std::fprintf(stderr, "perfect hash lost %.*s\n", static_cast<int>(key.size()), key.data());
+      return 1;
+    }
+  }
+  std::printf("%-8s %14s %14s %8s\n", "case", "perfect ns/op", "sorted ns/op", "speedup");
+  bench_import();
+  bench_id();
+  bench_miss();
+  return 0;
+}
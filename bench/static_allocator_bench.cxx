@@ -0,0 +1,116 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * static_allocator_bench.cxx - static_allocator against the pmr allocator<T> of the same heap.
+ *
+ * Each case runs the same container workload twice on the same arena, once with the heap's
+ * pmr allocator<T> (a virtual call per allocation) and once with its static_allocator<T> (a
+ * direct call), and prints the time per operation. The node containers allocate once per
+ * element, so they show the cost of the dispatch most clearly. Every figure is the best of
+ * ROUNDS runs, the two allocators taking turns on a freshly reset heap, so neither inherits
+ * the free lists of the other and a noisy host hurts both alike.
+ *
+ *   list      - push 64 nodes to a std::list and destroy it (bump heap, rewound every time)
+ *   list      - the same on the mspace heap
+ *   map       - erase and re-insert random keys of a std::map of 100 entries (mspace heap)
+ */
+#include "bench_common.hxx"
+#include <allocator/bump_allocator.hxx>
+#include <allocator/specified_allocator.hxx>
+#include <functional>
+#include <list>
+#include <map>
+#include <type_traits>
+
+namespace {
+
+using namespace fireball;
+using namespace fireball::bench;
+
+constexpr uint32_t ARENA_SIZE = 16U * 1024U * 1024U;
+constexpr std::size_t OPS = 20000U;
+constexpr std::size_t LIST_SIZE = 64U;
+constexpr std::size_t MAP_SIZE = 100U;
+constexpr std::size_t ROUNDS = 5U;
+
+struct spec_tag {};
+struct bump_tag {};
+using spec_heap = allocator::specified_allocator<ARENA_SIZE, spec_tag>;
+using bump_heap = allocator::bump_allocator<ARENA_SIZE, bump_tag>;
+
+/**
+ * Run both versions of a case ROUNDS times and print the best time of each.
+ */
+template <typename PmrCase, typename StaticCase>
+void run_case(const char* name, const char* heap, PmrCase&& pmr_case,
+              StaticCase&& static_case) noexcept {
+  auto pmr_ns = pmr_case();
+  auto static_ns = static_case();
+  for (std::size_t i = 1U; i < ROUNDS; ++i) {
+    pmr_ns = std::min(pmr_ns, pmr_case());
+    static_ns = std::min(static_ns, static_case());
+  }
+  std::printf("%-8s %-8s %10.1f %10.1f %7.2fx\n", name, heap, pmr_ns, static_ns,
+              pmr_ns / static_ns);
+}
+
+/**
+ * The bump arena is rewound after every round, as a component would on exit.
+ */
+template <typename Alloc> void rewind() noexcept {
+  if constexpr (std::is_same_v<typename Alloc::resource_type, bump_heap>) {
+    bump_heap::instance().reset();
+  }
+}
+
+template <typename Alloc> double bench_list() noexcept {
+  Alloc::resource_type::instance().reset();
+  return ns_per_op(OPS, [](std::size_t) {
+    {
+      std::list<uint32_t, Alloc> l;
+      for (uint32_t i = 0U; i < LIST_SIZE; ++i) {
+        l.push_back(i);
+      }
+      do_not_optimize(l.back());
+    }
+    rewind<Alloc>();
+  });
+}
+
+template <typename Alloc> double bench_map() noexcept {
+  using map_type = std::map<uint32_t, uint32_t, std::less<uint32_t>, Alloc>;
+  Alloc::resource_type::instance().reset();
+  map_type m;
+  std::array<uint32_t, MAP_SIZE> keys;
+  xorshift32 rng{1U};
+  for (uint32_t i = 0U; i < MAP_SIZE; ++i) {
+    keys[i] = rng.next();
+    m[keys[i]] = i;
+  }
+  return ns_per_op(OPS * 10U, [&](std::size_t i) {
+    const auto key = keys[(i * 37U) % MAP_SIZE];
+    m.erase(key);
+    m[key] = static_cast<uint32_t>(i);
+  });
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  std::printf("%-8s %-8s %10s %10s %8s\n", "case", "heap", "pmr ns", "static ns", "speedup");
+  using node = std::pair<const uint32_t, uint32_t>;
+  run_case("list", "bump", bench_list<bump_heap::allocator<uint32_t>>,
+           bench_list<bump_heap::static_allocator<uint32_t>>);
+  run_case("list", "mspace", bench_list<spec_heap::allocator<uint32_t>>,
+           bench_list<spec_heap::static_allocator<uint32_t>>);
+  run_case("map", "mspace", bench_map<spec_heap::allocator<node>>,
+           bench_map<spec_heap::static_allocator<node>>);
+  return 0;
+}
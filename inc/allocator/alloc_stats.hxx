@@ -0,0 +1,107 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_ALLOC_STATS_HXX
+#define FIREBALL_ALLOCATOR_ALLOC_STATS_HXX
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <commons.hxx>
+#include <cstddef>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * alloc_stats - Snapshot of the statistics of one allocator instance.
+ *
+ * live_bytes counts usable bytes (slab class size or mspace chunk payload), so it reflects
+ * what the partition actually gives out. histogram[i] counts requests of up to 16 << i bytes;
+ * the last bin also counts everything larger. footprint and free_bytes come from the mspace
+ * and are zero for allocators without one.
+ */
+struct alloc_stats {
+  static constexpr std::size_t HISTOGRAM_BINS = 12U;
+
+  std::size_t live_bytes;
+  std::size_t peak_bytes;
+  std::size_t alloc_count;
+  std::size_t free_count;
+  std::size_t failure_count;
+  std::size_t footprint;
+  std::size_t max_footprint;
+  std::size_t free_bytes;
+  std::array<std::size_t, HISTOGRAM_BINS> histogram;
+};
+
+/**
+ * stats_recorder - Collects alloc_stats for an allocator instance.
+ *
+ * The disabled specialization has no state and empty inline hooks, so an allocator holding it
+ * as a [[no_unique_address]] member pays nothing for statistics.
+ *
+ * Template Parameters:
+ *   Enabled - Whether statistics are collected
+ */
+template <bool Enabled> struct stats_recorder {
+public:
+  static constexpr bool ENABLED = true;
+
+  void on_allocate(std::size_t requested, std::size_t usable) noexcept {
+    stats_.live_bytes += usable;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.live_bytes);
+    ++stats_.alloc_count;
+    ++stats_.histogram[bin_of(requested)];
+  }
+
+  void on_deallocate(std::size_t usable) noexcept {
+    stats_.live_bytes -= usable;
+    ++stats_.free_count;
+  }
+
+  void on_failure(std::size_t requested) noexcept {
+    ++stats_.failure_count;
+    ++stats_.histogram[bin_of(requested)];
+  }
+
+  void on_reset(std::size_t live) noexcept { stats_.live_bytes = live; }
+
+  const alloc_stats& get() const noexcept { return stats_; }
+
+private:
+  static constexpr std::size_t bin_of(std::size_t bytes) noexcept {
+    const auto bin = static_cast<std::size_t>(std::bit_width((bytes - (bytes != 0U)) >> 4U));
+    return std::min(bin, alloc_stats::HISTOGRAM_BINS - 1U);
+  }
+
+  alloc_stats stats_ = {};
+}; // struct stats_recorder
+
+template <> struct stats_recorder<false> {
+public:
+  static constexpr bool ENABLED = false;
+
+  void on_allocate([[maybe_unused]] std::size_t requested,
+                   [[maybe_unused]] std::size_t usable) noexcept {}
+
+  void on_deallocate([[maybe_unused]] std::size_t usable) noexcept {}
+
+  void on_failure([[maybe_unused]] std::size_t requested) noexcept {}
+
+  void on_reset([[maybe_unused]] std::size_t live) noexcept {}
+
+  alloc_stats get() const noexcept { return {}; }
+}; // struct stats_recorder<false>
+
+/**
+ * Recorder selected by the build (meson option alloc_stats).
+ */
+using default_stats_recorder = stats_recorder<FIREBALL_ALLOC_STATS != 0>;
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_ALLOC_STATS_HXX
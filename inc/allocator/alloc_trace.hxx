@@ -0,0 +1,112 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_ALLOC_TRACE_HXX
+#define FIREBALL_ALLOCATOR_ALLOC_TRACE_HXX
+
+#include <allocator/partition.hxx>
+#include <bit>
+#include <commons.hxx>
+#include <cstddef>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * trace_op - Kind of a trace_record.
+ */
+enum class trace_op : uint8_t {
+  alloc,
+  free,
+  alloc_failed,
+};
+
+/**
+ * trace_record - One allocator event, 16 bytes.
+ *
+ * ptr holds the low 32 bits of the address, which is enough to pair an alloc with its free
+ * during replay. tag is the partition owning the block (partition_id::count outside
+ * partition_ram). size is 0 for unsized frees.
+ */
+struct trace_record {
+  uint32_t timestamp;
+  uint32_t size;
+  uint32_t ptr;
+  trace_op op;
+  uint8_t align_log2;
+  partition_id tag;
+  uint8_t reserved;
+};
+
+static_assert(sizeof(trace_record) == 16U, "trace_record must stay compact");
+
+/**
+ * trace_header - Header of a dumped trace, followed by count trace_records oldest first.
+ *
+ * dropped counts the records overwritten because the ring buffer was full.
+ */
+struct trace_header {
+  static constexpr uint32_t MAGIC = 0x54414246U; // "FBAT"
+  static constexpr uint16_t VERSION = 1U;
+
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t count;
+  uint32_t dropped;
+};
+
+/**
+ * Sink of alloc_trace_dump(); called with consecutive chunks of the dump.
+ */
+using trace_writer = void (*)(const void* data, std::size_t size, void* arg);
+
+namespace detail {
+extern bool alloc_trace_enabled;
+void alloc_trace_record(trace_op op, std::size_t size, std::size_t alignment,
+                        const void* ptr) noexcept;
+} // namespace detail
+
+/**
+ * Record an event into the trace ring buffer.
+ *
+ * It is an empty inline function unless the build enables FIREBALL_ALLOC_TRACE (meson option
+ * alloc_trace), and otherwise costs a flag test while recording is off.
+ */
+inline void alloc_trace([[maybe_unused]] trace_op op, [[maybe_unused]] std::size_t size,
+                        [[maybe_unused]] std::size_t alignment,
+                        [[maybe_unused]] const void* ptr) noexcept {
+#if FIREBALL_ALLOC_TRACE
+  if (detail::alloc_trace_enabled) {
+    detail::alloc_trace_record(op, size, alignment, ptr);
+  }
+#endif
+}
+
+/**
+ * Start or stop recording. Recording is off after boot.
+ */
+void alloc_trace_enable(bool enable) noexcept;
+
+/**
+ * Drop every recorded event.
+ */
+void alloc_trace_clear() noexcept;
+
+/**
+ * Write a trace_header and the recorded events through writer without allocating. Recording
+ * is paused while dumping. Returns the number of records written.
+ */
+std::size_t alloc_trace_dump(trace_writer writer, void* arg) noexcept;
+
+/**
+ * Dump the trace to a POSIX file descriptor (host builds only).
+ */
+std::size_t alloc_trace_dump_fd(int fd) noexcept;
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_ALLOC_TRACE_HXX
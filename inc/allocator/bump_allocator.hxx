@@ -6,6 +6,9 @@
 #ifndef FIREBALL_ALLOCATOR_BUMP_ALLOCATOR_HXX
 #define FIREBALL_ALLOCATOR_BUMP_ALLOCATOR_HXX
 
+#include <allocator/alloc_stats.hxx>
+#include <allocator/partition.hxx>
+#include <allocator/static_allocator.hxx>
 #include <commons.hxx>
 #include <memory_resource>
 
@@ -15,38 +18,175 @@ namespace allocator {
 /**
  * bump_allocator - Monotonic buffer resource for fixed-size heap partitions.
  *
- * This allocator implements a bump allocation strategy using std::pmr::monotonic_buffer_resource.
- * It is designed for heap partitions with predictable allocation patterns where deallocation
- * is not required (e.g., COOS kernel heap, WASM runtime heap). The allocator maintains a
- * fixed-size arena and allocates sequentially, returning memory only when the entire arena
- * is deallocated. This approach minimizes fragmentation and provides O(1) allocation time.
+ * This allocator implements a bump allocation strategy over a fixed-size arena. It is designed
+ * for heap partitions with predictable allocation patterns where deallocation is not required
+ * (e.g., COOS kernel heap, WASM runtime heap). The allocator allocates sequentially and
+ * individual deallocations are ignored. This approach minimizes fragmentation and provides O(1)
+ * allocation time.
+ *
+ * The current position can be saved with mark() and restored with release() in O(1), which
+ * rolls back everything allocated after the mark (e.g., a module parse that fails half-way).
+ * checkpoint does the same for a scope unless it is committed. reset() rewinds the whole arena
+ * without any upstream resource. Requests that do not fit return nullptr like
+ * specified_allocator.
+ *
+ * With FIREBALL_ALLOC_STATS enabled the instance keeps its own alloc_stats, see stats(). Live
+ * bytes are the used part of the arena including alignment padding.
+ *
+ * The instance is constant-initialized (constinit) with the address of its arena, so
+ * instance() carries no guard check and the allocator is usable before any constructor runs.
+ * Only an arena that FIREBALL_VM_ARENA reserves at run time waits for init() or the first
+ * allocation.
+ *
+ * The arena is provided by arena_of(): a Tag naming a partition places it in partition_ram.
  *
  * Template Parameters:
  *   N   - Size of the arena in bytes (compile-time constant)
  *   Tag - Type tag for distinguishing multiple allocator instances
  */
-template <uint32_t N, typename Tag>
-struct bump_allocator : public std::pmr::monotonic_buffer_resource {
+template <uint32_t N, typename Tag> struct bump_allocator : public std::pmr::memory_resource {
 public:
   using this_type = bump_allocator;
 
-  static this_type& instance() {
-    static this_type inst;
-    return inst;
+  /**
+   * marker - Saved arena position.
+   */
+  struct marker {
+    uint32_t offset;
+  };
+
+  /**
+   * checkpoint - Releases the arena back to its construction point unless committed.
+   */
+  class checkpoint {
+  public:
+    checkpoint() noexcept : marker_(this_type::instance().mark()), committed_(false) {}
+
+    ~checkpoint() noexcept {
+      if (!committed_) {
+        this_type::instance().release(marker_);
+      }
+    }
+
+    checkpoint(const checkpoint&) = delete;
+    checkpoint& operator=(const checkpoint&) = delete;
+
+    void commit() noexcept { committed_ = true; }
+
+  private:
+    marker marker_;
+    bool committed_;
+  };
+
+  static this_type& instance() noexcept { return instance_; }
+
+  /**
+   * Reserve the arena if its address is not a link-time constant; nothing to do otherwise.
+   */
+  void init() noexcept {
+    if (arena_ == nullptr) {
+      arena_ = arena_of<N, Tag>();
+    }
+  }
+
+  marker mark() const noexcept { return marker{offset_}; }
+
+  /**
+   * Free everything allocated after m. Markers newer than the current position are ignored.
+   */
+  void release(marker m) noexcept {
+    if (m.offset < offset_) {
+      offset_ = m.offset;
+      stats_.on_reset(offset_);
+    }
+  }
+
+  /**
+   * Free everything. On the native build a large used area gives its pages back to the kernel.
+   */
+  void reset() noexcept {
+    if (offset_ >= FIREBALL_VM_RELEASE_THRESHOLD) {
+      vm_release(arena_, offset_);
+    }
+    offset_ = 0U;
+    stats_.on_reset(offset_);
+  }
+
+  std::size_t used() const noexcept { return offset_; }
+
+  /**
+   * Grow or shrink the block p of old_bytes to new_bytes in place. Only the most recent block,
+   * which ends at the current position, can change size.
+   */
+  bool expand(void* p, std::size_t old_bytes, std::size_t new_bytes) noexcept {
+    const auto offset = reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(arena_);
+    if (offset > N || offset + old_bytes != offset_ || new_bytes > N - offset) {
+      return false;
+    }
+    offset_ = static_cast<uint32_t>(offset + new_bytes);
+    stats_.on_reset(offset_);
+    return true;
+  }
+
+  const uint8_t* begin() const noexcept { return arena_; }
+
+  const uint8_t* end() const noexcept { return arena_ + N; }
+
+  /**
+   * Statistics of this instance; all zero when FIREBALL_ALLOC_STATS is disabled.
+   */
+  alloc_stats stats() const noexcept { return stats_.get(); }
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if constexpr (!constant_arena_v<Tag>) {
+      init();
+    }
+    const auto base = reinterpret_cast<uintptr_t>(arena_);
+    const auto head = (base + offset_ + alignment - 1U) & ~(uintptr_t)(alignment - 1U);
+    const auto offset = head - base;
+    if (offset > N || bytes > N - offset) {
+      stats_.on_failure(bytes);
+      return nullptr;
+    }
+    stats_.on_allocate(bytes, offset + bytes - offset_);
+    offset_ = static_cast<uint32_t>(offset + bytes);
+    return reinterpret_cast<void*>(head);
   }
 
+  void do_deallocate([[maybe_unused]] void* p, [[maybe_unused]] std::size_t bytes,
+                     [[maybe_unused]] std::size_t alignment) override {
+    // nothing.
+  }
+
+  bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+
   template <typename T> struct allocator : public std::pmr::polymorphic_allocator<T> {
+    using resource_type = this_type;
+
     allocator() : std::pmr::polymorphic_allocator<T>(&this_type::instance()) {}
   };
 
+  /**
+   * Allocator calling this heap directly instead of through std::pmr::memory_resource.
+   */
+  template <typename T>
+  using static_allocator = fireball::allocator::static_allocator<T, this_type>;
+
 private:
-  bump_allocator()
-      : std::pmr::monotonic_buffer_resource(arena_, N, std::pmr::null_memory_resource()) {
+  constexpr bump_allocator() noexcept
+      : std::pmr::memory_resource(), offset_(0U), stats_(), arena_(constant_arena_of<N, Tag>()) {
     // nothing.
   }
 
-  uint8_t arena_[N];
-}; // struct bump_allocator : public std::pmr::monotonic_buffer_resource
+  uint32_t offset_;
+  [[no_unique_address]] default_stats_recorder stats_;
+  uint8_t* arena_;
+
+  static constinit this_type instance_;
+}; // struct bump_allocator : public std::pmr::memory_resource
+
+template <uint32_t N, typename Tag>
+constinit bump_allocator<N, Tag> bump_allocator<N, Tag>::instance_;
 
 } // namespace allocator
 } // namespace fireball
@@ -0,0 +1,44 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_CURRENT_CORE_HXX
+#define FIREBALL_ALLOCATOR_CURRENT_CORE_HXX
+
+#include <commons.hxx>
+
+namespace fireball {
+namespace allocator {
+
+namespace detail {
+#if FIREBALL_CORE_COUNT > 1
+extern thread_local uint32_t current_core;
+#endif
+} // namespace detail
+
+/**
+ * Index of the core running the caller (always 0 on single-core targets).
+ */
+inline uint32_t current_core() noexcept {
+#if FIREBALL_CORE_COUNT > 1
+  return detail::current_core;
+#else
+  return 0U;
+#endif
+}
+
+/**
+ * Bind the calling hypervisor instance to a core below FIREBALL_CORE_COUNT. Called once per
+ * core at startup, before the first allocation from a per-core heap.
+ */
+inline void bind_current_core([[maybe_unused]] uint32_t core) noexcept {
+#if FIREBALL_CORE_COUNT > 1
+  detail::current_core = core;
+#endif
+}
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_CURRENT_CORE_HXX
@@ -0,0 +1,66 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_FRAG_REPORT_HXX
+#define FIREBALL_ALLOCATOR_FRAG_REPORT_HXX
+
+#include <array>
+#include <commons.hxx>
+#include <cstddef>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * frag_report - Fragmentation of an mspace, collected with mspace_inspect_all.
+ *
+ * Tells a partition that is really full from one that is merely fragmented: free_bytes is
+ * plenty but largest_free is smaller than the failed request. histogram[i] counts free chunks
+ * of up to 16 << i bytes; the last bin also counts everything larger. map divides the arena
+ * into MAP_CELLS equal cells and marks whether each holds used and/or free chunks.
+ *
+ * Slab pages count as used chunks; free objects inside them are internal to the slab and do
+ * not appear here.
+ */
+struct frag_report {
+  static constexpr std::size_t HISTOGRAM_BINS = 12U;
+  static constexpr std::size_t MAP_CELLS = 64U;
+  static constexpr uint8_t MAP_USED = 1U;
+  static constexpr uint8_t MAP_FREE = 2U;
+
+  std::size_t used_bytes;
+  std::size_t used_chunks;
+  std::size_t free_bytes;
+  std::size_t free_chunks;
+  std::size_t largest_free;
+  std::array<std::size_t, HISTOGRAM_BINS> histogram;
+  std::array<uint8_t, MAP_CELLS> map;
+
+  /**
+   * External fragmentation in permille: 0 when all free memory is one block, close to 1000
+   * when it is scattered into small ones.
+   */
+  uint32_t fragmentation_permille() const noexcept {
+    return free_bytes == 0U ? 0U
+                            : static_cast<uint32_t>(1000U - largest_free * 1000U / free_bytes);
+  }
+};
+
+/**
+ * Walk every chunk of msp, whose arena is [begin, end). A null msp gives an empty report.
+ * Must not run concurrently with allocations from msp.
+ */
+extern frag_report inspect_fragmentation(void* msp, const uint8_t* begin,
+                                         const uint8_t* end) noexcept;
+
+/**
+ * Print report to stderr without allocating, e.g. right before an OOM terminates the system.
+ */
+extern void print_frag_report(const char* name, const frag_report& report) noexcept;
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_FRAG_REPORT_HXX
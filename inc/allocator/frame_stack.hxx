@@ -0,0 +1,150 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_FRAME_STACK_HXX
+#define FIREBALL_ALLOCATOR_FRAME_STACK_HXX
+
+#include <allocator/alloc_stats.hxx>
+#include <commons.hxx>
+#include <cstddef>
+#include <memory_resource>
+#include <utils/backtrace.hxx>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * frame_stack - Contiguous LIFO stack of interpreter call frames.
+ *
+ * A call pushes its frame (locals, operand stack, return info) with push() and the return
+ * pops it with pop(), each a pointer bump against a fixed limit. Every frame is rounded up to
+ * ALIGN, so the top stays aligned and popping a frame just moves the top back to its start.
+ * A push that would run past the limit returns nullptr; the interpreter turns it into a stack
+ * overflow trap.
+ *
+ * Unlike bump_allocator it is not a singleton: each coroutine running a guest owns its own
+ * frame_stack over a range carved from the coroutine stack partition with carve(), so a
+ * guest's frames stay contiguous in cache. As a memory_resource it releases a block only when
+ * it is the top frame; anything else is kept until the frames above it are popped.
+ */
+class frame_stack : public std::pmr::memory_resource {
+public:
+  static constexpr std::size_t ALIGN = alignof(std::max_align_t);
+
+  frame_stack(void* base, std::size_t size) noexcept
+      : std::pmr::memory_resource(), base_(static_cast<uint8_t*>(base)),
+        top_(static_cast<uint8_t*>(base)),
+        limit_(base == nullptr ? nullptr : static_cast<uint8_t*>(base) + size), stats_() {
+    ASSERT_WITH_BACKTRACE(reinterpret_cast<uintptr_t>(base) % ALIGN == 0U);
+  }
+
+  frame_stack(const frame_stack&) = delete;
+  frame_stack& operator=(const frame_stack&) = delete;
+
+  /**
+   * Carve a frame stack of size bytes out of the upstream resource, typically
+   * coroutine_stack_heap::instance(). The stack is empty (capacity 0) if upstream has no room.
+   */
+  static frame_stack carve(std::pmr::memory_resource& upstream, std::size_t size) noexcept {
+    return frame_stack(upstream.allocate(size, ALIGN), size);
+  }
+
+  /**
+   * Push a frame of bytes bytes aligned to ALIGN, or return nullptr on stack overflow.
+   */
+  void* push(std::size_t bytes) noexcept {
+    if (!fits(bytes)) {
+      stats_.on_failure(bytes);
+      return nullptr;
+    }
+    const auto size = round_up(bytes);
+    auto ret = top_;
+    top_ += size;
+    stats_.on_allocate(bytes, size);
+    return ret;
+  }
+
+  /**
+   * Pop frame, the result of a push(), together with every frame pushed after it.
+   */
+  void pop(void* frame) noexcept {
+    auto p = static_cast<uint8_t*>(frame);
+    ASSERT_WITH_BACKTRACE(base_ <= p && p <= top_);
+    top_ = p;
+    stats_.on_reset(used());
+  }
+
+  /**
+   * Grow the top frame in place by bytes (e.g., a deeper operand stack). Returns false on
+   * overflow, leaving the frame unchanged.
+   */
+  bool extend(std::size_t bytes) noexcept {
+    if (!fits(bytes)) {
+      return false;
+    }
+    top_ += round_up(bytes);
+    stats_.on_reset(used());
+    return true;
+  }
+
+  void reset() noexcept {
+    top_ = base_;
+    stats_.on_reset(0U);
+  }
+
+  std::size_t used() const noexcept { return static_cast<std::size_t>(top_ - base_); }
+
+  std::size_t capacity() const noexcept { return static_cast<std::size_t>(limit_ - base_); }
+
+  const uint8_t* begin() const noexcept { return base_; }
+
+  const uint8_t* end() const noexcept { return limit_; }
+
+  /**
+   * Statistics of this instance; all zero when FIREBALL_ALLOC_STATS is disabled.
+   */
+  alloc_stats stats() const noexcept { return stats_.get(); }
+
+protected:
+  void* do_allocate(std::size_t bytes, [[maybe_unused]] std::size_t alignment) override {
+    ASSERT_WITH_BACKTRACE(alignment <= ALIGN);
+    return push(bytes);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes,
+                     [[maybe_unused]] std::size_t alignment) override {
+    auto frame = static_cast<uint8_t*>(p);
+    if (p != nullptr && base_ <= frame && frame <= top_ &&
+        bytes <= static_cast<std::size_t>(top_ - frame) && frame + round_up(bytes) == top_) {
+      pop(p);
+    }
+  }
+
+  bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+  /**
+   * Returns true if a frame of bytes bytes, rounded up to ALIGN, fits above the top. bytes is
+   * checked before rounding, which would wrap around for sizes near SIZE_MAX.
+   */
+  bool fits(std::size_t bytes) const noexcept {
+    const auto room = static_cast<std::size_t>(limit_ - top_);
+    return bytes <= room && round_up(bytes) <= room;
+  }
+
+  static constexpr std::size_t round_up(std::size_t bytes) noexcept {
+    return (bytes + ALIGN - 1U) & ~(ALIGN - 1U);
+  }
+
+  uint8_t* base_;
+  uint8_t* top_;
+  uint8_t* limit_;
+  [[no_unique_address]] default_stats_recorder stats_;
+}; // class frame_stack : public std::pmr::memory_resource
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_FRAME_STACK_HXX
@@ -0,0 +1,337 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_HANDLE_HEAP_HXX
+#define FIREBALL_ALLOCATOR_HANDLE_HEAP_HXX
+
+#include <algorithm>
+#include <allocator/alloc_stats.hxx>
+#include <allocator/partition.hxx>
+#include <array>
+#include <commons.hxx>
+#include <cstddef>
+#include <cstring>
+#include <utils/backtrace.hxx>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * handle_heap - Relocatable blocks reached through a handle table, with incremental compaction.
+ *
+ * Blocks are laid out back to back from the start of the arena and new blocks are cut from the
+ * top in O(1). Owners keep a handle instead of a pointer, so the compactor may slide a block
+ * down over the free space below it and only has to patch one handle table entry. get() gives
+ * the current address, which stays valid until the next compact_step(); pin() keeps a block in
+ * place for as long as its address is held (e.g., across a call into the guest), and the
+ * compactor leaves a free gap in front of a pinned block instead of moving it.
+ *
+ * Freed blocks become holes. When the top is exhausted allocate() falls back to a first-fit
+ * walk over the holes, merging neighbours on the way. compact_step() runs one bounded slice of
+ * a sliding pass and is meant for the scheduler's idle time: a slice is charged for the blocks
+ * it visits as well as the bytes it moves, a pass that is interrupted keeps the heap walkable,
+ * allocations made meanwhile come from the top only, and the pass ends by handing all the space
+ * it squeezed out back to the top. A new pass starts only after a block has been freed or
+ * unpinned, so the gaps left in front of pinned blocks do not make every idle call rescan.
+ *
+ * A Tag with an `upstream` allocator type takes the arena from that allocator on first use, so
+ * the heap lives inside an existing partition (see guest_handle_heap); otherwise the arena is
+ * provided by arena_of().
+ *
+ * Template Parameters:
+ *   N       - Size of the arena in bytes (compile-time constant)
+ *   Tag     - Type tag for distinguishing multiple allocator instances
+ *   Handles - Number of entries of the handle table
+ */
+template <uint32_t N, typename Tag, uint16_t Handles> class handle_heap {
+public:
+  using this_type = handle_heap;
+
+  /**
+   * handle - Stable reference to a block.
+   */
+  struct handle {
+    uint16_t index;
+
+    bool valid() const noexcept { return index != NO_HANDLE; }
+  };
+
+  /**
+   * pin_guard - Pins a block for the lifetime of the guard.
+   */
+  class pin_guard {
+  public:
+    pin_guard(handle h) noexcept : handle_(h), ptr_(this_type::instance().pin(h)) {}
+
+    ~pin_guard() noexcept { this_type::instance().unpin(handle_); }
+
+    pin_guard(const pin_guard&) = delete;
+    pin_guard& operator=(const pin_guard&) = delete;
+
+    void* get() const noexcept { return ptr_; }
+
+  private:
+    handle handle_;
+    void* ptr_;
+  };
+
+  static this_type& instance() {
+    static this_type inst;
+    return inst;
+  }
+
+  /**
+   * Allocate a block of bytes bytes aligned to alignof(std::max_align_t). Returns an invalid
+   * handle if neither the top, nor a hole, nor the handle table has room.
+   */
+  handle allocate(std::size_t bytes) noexcept {
+    const auto size = block_size(bytes);
+    if (arena_ == nullptr || free_handle_ == NO_HANDLE || size > N) {
+      stats_.on_failure(bytes);
+      return handle{NO_HANDLE};
+    }
+    uint32_t offset;
+    if (size <= N - top_) {
+      offset = top_;
+      top_ += static_cast<uint32_t>(size);
+      block_at(offset)->size = static_cast<uint32_t>(size);
+    } else if (compacting_ || !take_hole(size, offset)) {
+      stats_.on_failure(bytes);
+      return handle{NO_HANDLE};
+    }
+    const auto index = free_handle_;
+    free_handle_ = static_cast<uint16_t>(handles_[index]);
+    handles_[index] = offset;
+    auto b = block_at(offset);
+    b->handle = index;
+    b->pins = 0U;
+    stats_.on_allocate(bytes, b->size - HEADER);
+    return handle{index};
+  }
+
+  /**
+   * Free the block of h. The handle must not be used afterwards.
+   */
+  void deallocate(handle h) noexcept {
+    if (!h.valid()) {
+      return;
+    }
+    ASSERT_WITH_BACKTRACE(h.index < Handles);
+    const auto offset = handles_[h.index];
+    auto b = block_at(offset);
+    ASSERT_WITH_BACKTRACE(b->handle == h.index && b->pins == 0U);
+    stats_.on_deallocate(b->size - HEADER);
+    b->handle = NO_HANDLE;
+    handles_[h.index] = free_handle_;
+    free_handle_ = h.index;
+    if (!compacting_ && offset + b->size == top_) {
+      top_ = offset;
+    } else if (!compacting_ || offset < dest_) {
+      // blocks at or above the scan position are absorbed by the running pass instead.
+      free_bytes_ += b->size;
+      dirty_ = true;
+    }
+  }
+
+  /**
+   * Current address of the block of h, valid until the next compact_step().
+   */
+  void* get(handle h) const noexcept {
+    ASSERT_WITH_BACKTRACE(h.valid() && h.index < Handles);
+    return payload_of(block_at(handles_[h.index]));
+  }
+
+  /**
+   * Keep the block of h in place until the matching unpin(). Pins nest.
+   */
+  void* pin(handle h) noexcept {
+    ASSERT_WITH_BACKTRACE(h.valid() && h.index < Handles);
+    auto b = block_at(handles_[h.index]);
+    ++b->pins;
+    return payload_of(b);
+  }
+
+  void unpin(handle h) noexcept {
+    ASSERT_WITH_BACKTRACE(h.valid() && h.index < Handles);
+    auto b = block_at(handles_[h.index]);
+    ASSERT_WITH_BACKTRACE(b->pins != 0U);
+    if (--b->pins == 0U) {
+      // the gap in front of the block can be closed now.
+      dirty_ = true;
+    }
+  }
+
+  /**
+   * Run the compactor until about budget bytes have been moved, every block visited counting
+   * for SCAN_COST bytes more. Returns true when no pass is in progress any more, i.e. the heap
+   * is compact apart from gaps in front of pinned blocks and holes freed in the meantime. No
+   * pass is started unless a block has been freed or unpinned since the previous one.
+   */
+  bool compact_step(std::size_t budget) noexcept {
+    if (!compacting_) {
+      if (free_bytes_ == 0U || !dirty_) {
+        return true;
+      }
+      dirty_ = false;
+      compacting_ = true;
+      scan_ = 0U;
+      dest_ = 0U;
+      free_bytes_ = 0U;
+    }
+    std::size_t spent = 0U;
+    while (scan_ < top_ && spent < budget) {
+      auto b = block_at(scan_);
+      const auto size = b->size;
+      spent += SCAN_COST;
+      if (b->handle == NO_HANDLE) {
+        // nothing.
+      } else if (b->pins != 0U) {
+        if (dest_ != scan_) {
+          make_hole(dest_, scan_ - dest_);
+          free_bytes_ += scan_ - dest_;
+        }
+        dest_ = scan_ + size;
+      } else {
+        if (dest_ != scan_) {
+          std::memmove(arena_ + dest_, b, size);
+          handles_[block_at(dest_)->handle] = dest_;
+          spent += size;
+        }
+        dest_ += size;
+      }
+      scan_ += size;
+    }
+    if (scan_ < top_) {
+      // keep [dest_, scan_) walkable until the next step.
+      if (dest_ != scan_) {
+        make_hole(dest_, scan_ - dest_);
+      }
+      return false;
+    }
+    top_ = dest_;
+    compacting_ = false;
+    return true;
+  }
+
+  /**
+   * Bytes left for new blocks: the top plus every hole.
+   */
+  std::size_t available() const noexcept { return N - top_ + free_bytes_; }
+
+  const uint8_t* begin() const noexcept { return arena_; }
+
+  const uint8_t* end() const noexcept { return arena_ + N; }
+
+  /**
+   * Statistics of this instance; all zero when FIREBALL_ALLOC_STATS is disabled.
+   */
+  alloc_stats stats() const noexcept { return stats_.get(); }
+
+private:
+  static constexpr uint16_t NO_HANDLE = 0xFFFFU;
+  static constexpr std::size_t ALIGN = alignof(std::max_align_t);
+
+  static_assert(Handles < NO_HANDLE, "too many handles");
+
+  /**
+   * Header in front of every block; handle is NO_HANDLE for a hole. size includes the header.
+   */
+  struct block_header {
+    uint32_t size;
+    uint16_t handle;
+    uint16_t pins;
+  };
+
+  static constexpr std::size_t HEADER = (sizeof(block_header) + ALIGN - 1U) & ~(ALIGN - 1U);
+
+  /**
+   * Budget charged by compact_step() for visiting a block, whether it moves or not.
+   */
+  static constexpr std::size_t SCAN_COST = HEADER;
+
+  static std::size_t block_size(std::size_t bytes) noexcept {
+    return HEADER + std::max<std::size_t>((bytes + ALIGN - 1U) & ~(ALIGN - 1U), ALIGN);
+  }
+
+  static void* payload_of(block_header* b) noexcept {
+    return reinterpret_cast<uint8_t*>(b) + HEADER;
+  }
+
+  block_header* block_at(uint32_t offset) const noexcept {
+    return reinterpret_cast<block_header*>(arena_ + offset);
+  }
+
+  void make_hole(uint32_t offset, uint32_t size) noexcept {
+    auto b = block_at(offset);
+    b->size = size;
+    b->handle = NO_HANDLE;
+    b->pins = 0U;
+  }
+
+  /**
+   * First-fit search of the holes below the top, merging adjacent holes as it goes. The chosen
+   * hole is split when the rest can hold a block of its own.
+   */
+  bool take_hole(std::size_t size, uint32_t& offset) noexcept {
+    if (free_bytes_ < size) {
+      return false;
+    }
+    for (uint32_t at = 0U; at < top_; at += block_at(at)->size) {
+      auto b = block_at(at);
+      if (b->handle != NO_HANDLE) {
+        continue;
+      }
+      for (auto next = at + b->size; next < top_ && block_at(next)->handle == NO_HANDLE;
+           next = at + b->size) {
+        b->size += block_at(next)->size;
+      }
+      if (b->size < size) {
+        continue;
+      }
+      if (b->size - size >= block_size(0U)) {
+        make_hole(static_cast<uint32_t>(at + size), static_cast<uint32_t>(b->size - size));
+        b->size = static_cast<uint32_t>(size);
+      }
+      free_bytes_ -= b->size;
+      offset = at;
+      return true;
+    }
+    return false;
+  }
+
+  static uint8_t* acquire_arena() noexcept {
+    if constexpr (requires { typename Tag::upstream; }) {
+      return static_cast<uint8_t*>(Tag::upstream::instance().allocate(N, ALIGN));
+    } else {
+      return arena_of<N, Tag>();
+    }
+  }
+
+  handle_heap()
+      : handles_(), free_handle_(0U), top_(0U), free_bytes_(0U), scan_(0U), dest_(0U),
+        compacting_(false), dirty_(false), stats_(), arena_(acquire_arena()) {
+    for (uint16_t i = 0U; i < Handles; ++i) {
+      handles_[i] = i + 1U < Handles ? i + 1U : NO_HANDLE;
+    }
+  }
+
+  // offset of the block of a live handle, or the next free handle.
+  std::array<uint32_t, Handles> handles_;
+  uint16_t free_handle_;
+  uint32_t top_;
+  uint32_t free_bytes_;
+  uint32_t scan_;
+  uint32_t dest_;
+  bool compacting_;
+  // a block was freed or unpinned since the last pass started.
+  bool dirty_;
+  [[no_unique_address]] default_stats_recorder stats_;
+  uint8_t* arena_;
+}; // class handle_heap
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_HANDLE_HEAP_HXX
@@ -0,0 +1,79 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_HEAP_PROFILER_HXX
+#define FIREBALL_ALLOCATOR_HEAP_PROFILER_HXX
+
+#include <commons.hxx>
+#include <cstddef>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * Sink of heap_profile_dump(); called with consecutive chunks of the text dump.
+ */
+using profile_writer = void (*)(const void* data, std::size_t size, void* arg);
+
+namespace detail {
+extern std::ptrdiff_t heap_profile_countdown;
+[[gnu::noinline]] void heap_profile_record(std::size_t bytes) noexcept;
+} // namespace detail
+
+/**
+ * Account bytes allocated by operator new and take a sample once about one sampling interval
+ * of bytes has been allocated since the last one.
+ *
+ * The countdown stays at its maximum while the profiler is stopped, so the cost is one
+ * subtraction and one branch. Without FIREBALL_HEAP_PROFILE (meson option heap_profile) this
+ * is an empty inline function. It is always inlined, even at -Og, as the recorded stack skips
+ * exactly the frames of heap_profile_record() and operator new.
+ */
+[[gnu::always_inline]] inline void
+heap_profile_sample([[maybe_unused]] std::size_t bytes) noexcept {
+#if FIREBALL_HEAP_PROFILE
+  detail::heap_profile_countdown -= static_cast<std::ptrdiff_t>(bytes);
+  if (detail::heap_profile_countdown < 0) [[unlikely]] {
+    detail::heap_profile_record(bytes);
+  }
+#endif
+}
+
+/**
+ * Start sampling about once per interval bytes (randomized around it so periodic allocation
+ * patterns are not aliased).
+ */
+void heap_profile_start(std::size_t interval) noexcept;
+
+/**
+ * Stop sampling; the collected call sites are kept for heap_profile_dump().
+ */
+void heap_profile_stop() noexcept;
+
+/**
+ * Drop every call site collected so far.
+ */
+void heap_profile_clear() noexcept;
+
+/**
+ * Write the table as text through writer without allocating:
+ *
+ *   heap_profile v1 interval=<bytes> base=0x<load address> dropped=<samples>
+ *   <estimated bytes> <samples> 0x<pc> 0x<pc> ...
+ *
+ * One line per call site, innermost return address first. dropped counts samples lost because
+ * the table was full. tools/symbolize_heap_profile.sh turns the addresses into functions.
+ */
+void heap_profile_dump(profile_writer writer, void* arg) noexcept;
+
+/**
+ * Dump the profile to a POSIX file descriptor (host builds only).
+ */
+void heap_profile_dump_fd(int fd) noexcept;
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_HEAP_PROFILER_HXX
@@ -0,0 +1,210 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_PARTITION_HXX
+#define FIREBALL_ALLOCATOR_PARTITION_HXX
+
+#include <allocator/vm_arena.hxx>
+#include <array>
+#include <commons.hxx>
+#include <concepts>
+#include <cstddef>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * partition_id - Heap partitions of the system RAM (see docs/agent/architecture/overview.md).
+ *
+ * host is the heap of the C++ standard library used when no COOS task is running.
+ */
+enum class partition_id : uint8_t {
+  coos_kernel,
+  wasm_runtime,
+  subsystem,
+  service,
+  guest,
+  coroutine_stack,
+  host,
+  count,
+};
+
+/**
+ * partition_desc - Location of a partition inside partition_ram.
+ */
+struct partition_desc {
+  uint32_t offset;
+  uint32_t size;
+};
+
+namespace detail {
+
+inline constexpr std::size_t PARTITION_COUNT = static_cast<std::size_t>(partition_id::count);
+
+inline constexpr std::array<uint32_t, PARTITION_COUNT> partition_sizes = {
+    FIREBALL_COOS_KERNEL_HEAP_SIZE, FIREBALL_WASM_RUNTIME_HEAP_SIZE,
+    FIREBALL_SUBSYSTEM_HEAP_SIZE,   FIREBALL_SERVICE_HEAP_SIZE,
+    FIREBALL_GUEST_HEAP_SIZE,       FIREBALL_CORO_STACK_AREA_SIZE,
+    FIREBALL_HOST_HEAP_SIZE,
+};
+
+constexpr std::array<partition_desc, PARTITION_COUNT> make_partition_layout() {
+  std::array<partition_desc, PARTITION_COUNT> ret = {};
+  uint32_t offset = 0U;
+  for (std::size_t i = 0U; i < PARTITION_COUNT; ++i) {
+    ret[i] = partition_desc{offset, partition_sizes[i]};
+    offset += partition_sizes[i];
+  }
+  return ret;
+}
+
+constexpr bool partition_sizes_are_granular() {
+  for (auto size : partition_sizes) {
+    if (size == 0U || size % FIREBALL_PARTITION_GRANULE != 0U) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+/**
+ * Layout of all partitions, contiguous and in partition_id order.
+ */
+inline constexpr auto partition_layout = detail::make_partition_layout();
+
+inline constexpr uint32_t PARTITION_RAM_SIZE =
+    partition_layout.back().offset + partition_layout.back().size;
+
+inline constexpr uint32_t PARTITION_GRANULES = PARTITION_RAM_SIZE / FIREBALL_PARTITION_GRANULE;
+
+static_assert((FIREBALL_PARTITION_GRANULE & (FIREBALL_PARTITION_GRANULE - 1U)) == 0U,
+              "partition granule must be a power of two");
+static_assert(FIREBALL_PARTITION_GRANULE % FIREBALL_CACHE_LINE_SIZE == 0U,
+              "partitions must start on a cache line");
+static_assert(detail::partition_sizes_are_granular(),
+              "partition sizes must be non-zero multiples of FIREBALL_PARTITION_GRANULE");
+static_assert(PARTITION_RAM_SIZE <= FIREBALL_TARGET_RAM_SIZE - FIREBALL_SYSTEM_RAM_RESERVE,
+              "heap partitions do not fit the target RAM");
+
+namespace detail {
+
+constexpr std::array<partition_id, PARTITION_GRANULES> make_granule_map() {
+  std::array<partition_id, PARTITION_GRANULES> ret = {};
+  for (std::size_t i = 0U; i < PARTITION_COUNT; ++i) {
+    const auto first = partition_layout[i].offset / FIREBALL_PARTITION_GRANULE;
+    const auto last = first + partition_layout[i].size / FIREBALL_PARTITION_GRANULE;
+    for (auto g = first; g < last; ++g) {
+      ret[g] = static_cast<partition_id>(i);
+    }
+  }
+  return ret;
+}
+
+} // namespace detail
+
+/**
+ * Owning partition of every granule of partition_ram, kept in ROM.
+ */
+inline constexpr auto partition_granule_map = detail::make_granule_map();
+
+/**
+ * The single static RAM block holding every partition (defined in partition.cxx).
+ */
+alignas(FIREBALL_CACHE_LINE_SIZE) extern uint8_t partition_ram[PARTITION_RAM_SIZE];
+
+/**
+ * Granule index of p inside partition_ram, or PARTITION_GRANULES if p lies outside.
+ */
+inline std::size_t partition_granule_of(const void* p) noexcept {
+  const auto offset = reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(partition_ram);
+  return offset < PARTITION_RAM_SIZE ? offset / FIREBALL_PARTITION_GRANULE : PARTITION_GRANULES;
+}
+
+/**
+ * Partition owning p in O(1), or partition_id::count if p lies outside partition_ram.
+ */
+inline partition_id partition_of(const void* p) noexcept {
+  const auto granule = partition_granule_of(p);
+  return granule < PARTITION_GRANULES ? partition_granule_map[granule] : partition_id::count;
+}
+
+/**
+ * Tags with a static `partition` member place their allocator's arena in that partition.
+ */
+template <typename Tag>
+concept partition_tag = requires {
+  { Tag::partition } -> std::convertible_to<partition_id>;
+};
+
+/**
+ * Offset of the arena of a partition tag inside its partition: Tag::offset if the tag has one,
+ * so that several arenas (e.g., those of per_core_allocator) can share a partition, 0 otherwise.
+ */
+template <typename Tag> constexpr uint32_t partition_offset_of() noexcept {
+  if constexpr (requires { Tag::offset; }) {
+    return Tag::offset;
+  } else {
+    return 0U;
+  }
+}
+
+template <typename Tag> inline constexpr uint32_t partition_offset_v = partition_offset_of<Tag>();
+
+namespace detail {
+
+template <uint32_t N, typename Tag>
+alignas(FIREBALL_CACHE_LINE_SIZE) inline uint8_t arena_storage[N];
+
+} // namespace detail
+
+/**
+ * Whether the arena of Tag has an address known at link time. Only the arenas that
+ * FIREBALL_VM_ARENA reserves at run time do not.
+ */
+template <typename Tag>
+inline constexpr bool constant_arena_v = partition_tag<Tag> || !FIREBALL_VM_ARENA;
+
+/**
+ * Arena of the allocator instance identified by N and Tag as a constant expression, so that
+ * allocators can be constant-initialized with it; nullptr if !constant_arena_v<Tag>.
+ */
+template <uint32_t N, typename Tag> constexpr uint8_t* constant_arena_of() noexcept {
+  if constexpr (partition_tag<Tag>) {
+    constexpr auto desc = partition_layout[static_cast<std::size_t>(Tag::partition)];
+    constexpr auto offset = partition_offset_v<Tag>;
+    static_assert(offset <= desc.size && N <= desc.size - offset,
+                  "allocator does not fit its partition");
+    static_assert(offset % FIREBALL_CACHE_LINE_SIZE == 0U, "arena must start on a cache line");
+    return partition_ram + desc.offset + offset;
+  } else if constexpr (FIREBALL_VM_ARENA) {
+    return nullptr;
+  } else {
+    return detail::arena_storage<N, Tag>;
+  }
+}
+
+/**
+ * Arena of the allocator instance identified by N and Tag.
+ *
+ * Partition tags get their partition (from Tag::offset on, if given) inside partition_ram; other
+ * tags (tools, benchmarks) get a zero-initialized static array, which needs no guard variable.
+ * With FIREBALL_VM_ARENA those arenas are reserved with vm_reserve() instead, so large arenas
+ * only occupy the pages in use.
+ */
+template <uint32_t N, typename Tag> inline uint8_t* arena_of() noexcept {
+  if constexpr (constant_arena_v<Tag>) {
+    return constant_arena_of<N, Tag>();
+  } else {
+    static uint8_t* const arena = vm_reserve(N);
+    return arena;
+  }
+}
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_PARTITION_HXX
@@ -0,0 +1,90 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_PARTITION_HEAPS_HXX
+#define FIREBALL_ALLOCATOR_PARTITION_HEAPS_HXX
+
+#include <allocator/bump_allocator.hxx>
+#include <allocator/frame_stack.hxx>
+#include <allocator/handle_heap.hxx>
+#include <allocator/partition.hxx>
+#include <allocator/specified_allocator.hxx>
+#include <allocator/tlsf_allocator.hxx>
+#include <commons.hxx>
+#include <type_traits>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * partition_heap_tag - Type tag placing an allocator in the partition Id.
+ */
+template <partition_id Id> struct partition_heap_tag {
+  static constexpr partition_id partition = Id;
+};
+
+template <partition_id Id>
+inline constexpr uint32_t partition_size_v = partition_layout[static_cast<std::size_t>(Id)].size;
+
+/**
+ * Allocator of a dynamic partition: TLSF when Tlsf is set, dlmalloc otherwise.
+ */
+template <partition_id Id, bool Tlsf>
+using dynamic_heap =
+    std::conditional_t<Tlsf, tlsf_allocator<partition_size_v<Id>, partition_heap_tag<Id>>,
+                       specified_allocator<partition_size_v<Id>, partition_heap_tag<Id>>>;
+
+/**
+ * Allocators of the heap partitions. Partitions released only as a whole use bump_allocator,
+ * the others dlmalloc or TLSF as selected by FIREBALL_*_HEAP_TLSF (see
+ * docs/agent/patterns/stdlib.md).
+ */
+using coos_kernel_heap = bump_allocator<partition_size_v<partition_id::coos_kernel>,
+                                        partition_heap_tag<partition_id::coos_kernel>>;
+using wasm_runtime_heap = bump_allocator<partition_size_v<partition_id::wasm_runtime>,
+                                         partition_heap_tag<partition_id::wasm_runtime>>;
+using subsystem_heap = dynamic_heap<partition_id::subsystem, FIREBALL_SUBSYSTEM_HEAP_TLSF != 0>;
+using service_heap = dynamic_heap<partition_id::service, FIREBALL_SERVICE_HEAP_TLSF != 0>;
+using guest_heap = dynamic_heap<partition_id::guest, FIREBALL_GUEST_HEAP_TLSF != 0>;
+using coroutine_stack_heap = bump_allocator<partition_size_v<partition_id::coroutine_stack>,
+                                            partition_heap_tag<partition_id::coroutine_stack>>;
+
+/**
+ * Interpreter frame stack of a new coroutine, carved from the coroutine stack partition. Its
+ * memory comes back only when the whole partition is reset.
+ */
+inline frame_stack make_coroutine_frame_stack() noexcept {
+  return frame_stack::carve(coroutine_stack_heap::instance(), FIREBALL_FRAME_STACK_SIZE);
+}
+
+/**
+ * guest_handle_heap_tag - Carves the relocatable guest heap out of the guest partition.
+ */
+struct guest_handle_heap_tag {
+  using upstream = guest_heap;
+};
+
+/**
+ * Relocatable blocks of long-lived guest data, compacted in the scheduler's idle time.
+ */
+using guest_handle_heap = handle_heap<FIREBALL_GUEST_HANDLE_HEAP_SIZE, guest_handle_heap_tag,
+                                      FIREBALL_GUEST_HANDLE_COUNT>;
+
+static_assert(FIREBALL_GUEST_HANDLE_HEAP_SIZE < FIREBALL_GUEST_HEAP_SIZE,
+              "relocatable guest heap must leave room in the guest partition");
+
+/**
+ * Lay out every partition heap, including the host heap of stdcxx_allocator, in partition_id
+ * order. main() calls it first thing during boot, so that no allocation pays for building its
+ * heap and the cost of the boot is in one place; the heaps themselves are constant-initialized
+ * and need no constructor to run before it. A heap allocated from earlier (e.g. by a static
+ * constructor) lays itself out on first use, and this call then leaves it as it is.
+ */
+extern void init_partition_heaps() noexcept;
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_PARTITION_HEAPS_HXX
@@ -0,0 +1,150 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_PER_CORE_ALLOCATOR_HXX
+#define FIREBALL_ALLOCATOR_PER_CORE_ALLOCATOR_HXX
+
+#include <allocator/current_core.hxx>
+#include <allocator/partition.hxx>
+#include <allocator/remote_free_queue.hxx>
+#include <allocator/specified_allocator.hxx>
+#include <allocator/static_allocator.hxx>
+#include <array>
+#include <commons.hxx>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * per_core_allocator - One specified_allocator per core with remote frees.
+ *
+ * Each core allocates from its own mspace, so dlmalloc needs no locks (USE_LOCKS=0). A block
+ * freed by its owning core goes straight back to that core's heap. A block freed by a foreign
+ * core (e.g., a co_value buffer handed over between cores) is pushed onto the owner's
+ * remote_free_queue, and the owner drains the queue on its next allocation. Only the owner core
+ * ever touches its mspace.
+ *
+ * If Tag names a partition, the arenas of the cores are consecutive slices of N bytes of that
+ * partition, so they lie in partition_ram like any other partition heap and can back task heaps.
+ *
+ * Template Parameters:
+ *   N     - Size of the arena of each core in bytes (compile-time constant)
+ *   Tag   - Type tag for distinguishing multiple allocator instances
+ *   Cores - Number of cores (FIREBALL_CORE_COUNT by default)
+ */
+template <uint32_t N, typename Tag, uint32_t Cores = FIREBALL_CORE_COUNT>
+struct per_core_allocator : public std::pmr::memory_resource {
+public:
+  using this_type = per_core_allocator;
+
+  template <uint32_t Core> struct plain_core_tag {};
+
+  /**
+   * Places the arena of Core at Core * N bytes into the partition of Tag.
+   */
+  template <uint32_t Core> struct partition_core_tag {
+    static constexpr partition_id partition = Tag::partition;
+    static constexpr uint32_t offset = partition_offset_v<Tag> + Core * N;
+  };
+
+  template <uint32_t Core>
+  using core_tag = std::conditional_t<partition_tag<Tag>, partition_core_tag<Core>,
+                                      plain_core_tag<Core>>;
+
+  template <uint32_t Core> using core_heap = specified_allocator<N, core_tag<Core>>;
+
+  static this_type& instance() {
+    static this_type inst;
+    return inst;
+  }
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    const auto core = current_core();
+    drain(core);
+    return cores_[core].heap->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    if (p == nullptr) {
+      return;
+    }
+    const auto core = current_core();
+    const auto owner = owner_of(p);
+    if constexpr (Cores > 1U) {
+      if (owner != core) {
+        cores_[owner].queue.push(p);
+        return;
+      }
+    }
+    cores_[owner].heap->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+
+  /**
+   * Return the blocks freed by foreign cores to the heap of core.
+   */
+  void drain(uint32_t core) noexcept {
+    if constexpr (Cores > 1U) {
+      auto n = cores_[core].queue.take_all();
+      while (n != nullptr) {
+        auto next = n->next;
+        cores_[core].heap->deallocate(n, 0U);
+        n = next;
+      }
+    }
+  }
+
+  template <typename T> struct allocator : public std::pmr::polymorphic_allocator<T> {
+    allocator() : std::pmr::polymorphic_allocator<T>(&this_type::instance()) {}
+  };
+
+  /**
+   * Allocator calling this heap directly instead of through std::pmr::memory_resource.
+   */
+  template <typename T>
+  using static_allocator = fireball::allocator::static_allocator<T, this_type>;
+
+private:
+  struct alignas(FIREBALL_CACHE_LINE_SIZE) core_slot {
+    std::pmr::memory_resource* heap;
+    const uint8_t* begin;
+    const uint8_t* end;
+    remote_free_queue queue;
+  };
+
+  template <std::size_t... I>
+  static std::array<core_slot, Cores> make_cores(std::index_sequence<I...>) noexcept {
+    (core_heap<I>::instance().init(), ...);
+    return {core_slot{&core_heap<I>::instance(), core_heap<I>::instance().begin(),
+                      core_heap<I>::instance().end(), remote_free_queue()}...};
+  }
+
+  per_core_allocator()
+      : std::pmr::memory_resource(), cores_(make_cores(std::make_index_sequence<Cores>())) {
+    // nothing.
+  }
+
+  uint32_t owner_of(const void* p) const noexcept {
+    const auto q = static_cast<const uint8_t*>(p);
+    for (uint32_t i = 1U; i < Cores; ++i) {
+      if (cores_[i].begin <= q && q < cores_[i].end) {
+        return i;
+      }
+    }
+    return 0U;
+  }
+
+  std::array<core_slot, Cores> cores_;
+
+}; // struct per_core_allocator : public std::pmr::memory_resource
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_PER_CORE_ALLOCATOR_HXX
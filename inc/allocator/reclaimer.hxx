@@ -0,0 +1,89 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_RECLAIMER_HXX
+#define FIREBALL_ALLOCATOR_RECLAIMER_HXX
+
+#include <array>
+#include <commons.hxx>
+#include <cstddef>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * Callback releasing cached memory of a partition (e.g., JIT code cache eviction, log ring
+ * shrinking, decoded bytecode drops). It should free about wanted bytes back to the partition
+ * and returns how many it released.
+ */
+using reclaim_fn = std::size_t (*)(std::size_t wanted, void* arg);
+
+/**
+ * reclaimer_list - Reclaimers of one allocator instance, run in registration order.
+ *
+ * run() stops as soon as enough memory has been released, so register the cheapest caches to
+ * drop first. It does not nest: a reclaimer that allocates from the same partition while
+ * running cannot trigger the list again.
+ */
+class reclaimer_list {
+public:
+  static constexpr std::size_t CAPACITY = FIREBALL_MAX_RECLAIMERS;
+
+  /**
+   * Returns false if CAPACITY reclaimers are already registered.
+   */
+  bool add(reclaim_fn fn, void* arg) noexcept {
+    if (count_ == CAPACITY) {
+      return false;
+    }
+    entries_[count_++] = entry{fn, arg};
+    return true;
+  }
+
+  void remove(reclaim_fn fn, void* arg) noexcept {
+    for (std::size_t i = 0U; i < count_; ++i) {
+      if (entries_[i].fn == fn && entries_[i].arg == arg) {
+        for (auto j = i + 1U; j < count_; ++j) {
+          entries_[j - 1U] = entries_[j];
+        }
+        --count_;
+        return;
+      }
+    }
+  }
+
+  bool empty() const noexcept { return count_ == 0U; }
+
+  /**
+   * Run reclaimers until wanted bytes are released. Returns the bytes released.
+   */
+  std::size_t run(std::size_t wanted) noexcept {
+    if (running_) {
+      return 0U;
+    }
+    running_ = true;
+    std::size_t released = 0U;
+    for (std::size_t i = 0U; i < count_ && released < wanted; ++i) {
+      released += entries_[i].fn(wanted - released, entries_[i].arg);
+    }
+    running_ = false;
+    return released;
+  }
+
+private:
+  struct entry {
+    reclaim_fn fn;
+    void* arg;
+  };
+
+  std::array<entry, CAPACITY> entries_ = {};
+  std::size_t count_ = 0U;
+  bool running_ = false;
+}; // class reclaimer_list
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_RECLAIMER_HXX
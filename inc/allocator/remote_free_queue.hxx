@@ -0,0 +1,50 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_REMOTE_FREE_QUEUE_HXX
+#define FIREBALL_ALLOCATOR_REMOTE_FREE_QUEUE_HXX
+
+#include <atomic>
+#include <commons.hxx>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * remote_free_queue - Lock-free MPSC queue of blocks freed by foreign cores.
+ *
+ * The link is stored in the freed block itself. Producers push with a CAS loop; the owning core
+ * takes the whole list with one exchange, so the queue is free of ABA problems.
+ */
+class remote_free_queue {
+public:
+  struct node {
+    node* next;
+  };
+
+  void push(void* p) noexcept {
+    auto n = static_cast<node*>(p);
+    n->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(n->next, n, std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+      // retry.
+    }
+  }
+
+  node* take_all() noexcept {
+    if (head_.load(std::memory_order_relaxed) == nullptr) {
+      return nullptr;
+    }
+    return head_.exchange(nullptr, std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<node*> head_ = nullptr;
+}; // class remote_free_queue
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_REMOTE_FREE_QUEUE_HXX
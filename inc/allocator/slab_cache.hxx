@@ -0,0 +1,227 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_SLAB_CACHE_HXX
+#define FIREBALL_ALLOCATOR_SLAB_CACHE_HXX
+
+#include <array>
+#include <commons.hxx>
+#include <cstddef>
+#include <cstdint>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * slab_cache - Size-class free lists in front of an mspace arena.
+ *
+ * Small requests are rounded up to a multiple of FIREBALL_SLAB_GRANULE and served from a doubly
+ * linked free list per size class, so allocation and deallocation are a list pop/push plus a
+ * page table lookup. When a class runs dry its owner refills it with one page of
+ * FIREBALL_SLAB_PAGE_SIZE bytes, an ordinary mspace chunk carved into equally sized objects
+ * without any per-object header. Pages are not aligned to their size (the alignment gaps would
+ * cost more than the headers saved), so the page table keeps, for every PAGE_SIZE stretch of the
+ * arena, where a page starts in it, if one does; the page owning a pointer starts in the stretch
+ * of the pointer or in the one before.
+ *
+ * Every page counts its objects in use. A page whose last object is freed is kept as the spare
+ * of its class, so a class alternating between n and n + 1 objects does not go back to the
+ * mspace each time; a second empty page of the class is returned to the mspace at once, and the
+ * owner takes back the spares with release_spare() when the mspace runs out.
+ *
+ * Template Parameters:
+ *   N - Size of the arena covered by the page table in bytes (compile-time constant)
+ */
+template <uint32_t N> class slab_cache {
+public:
+  static constexpr std::size_t PAGE_SIZE = FIREBALL_SLAB_PAGE_SIZE;
+  static constexpr std::size_t GRANULE = FIREBALL_SLAB_GRANULE;
+  static constexpr std::size_t MAX_SIZE = FIREBALL_SLAB_MAX_SIZE;
+  static constexpr std::size_t NUM_CLASSES = MAX_SIZE / GRANULE;
+  static constexpr std::size_t NUM_PAGES = (N + PAGE_SIZE - 1U) / PAGE_SIZE + 1U;
+  static constexpr std::size_t NO_PAGE = SIZE_MAX;
+
+  /**
+   * Alignment of the mspace chunks and so of the pages (dlmalloc's MALLOC_ALIGNMENT).
+   */
+  static constexpr std::size_t PAGE_ALIGN = 2U * sizeof(void*);
+
+  static_assert((PAGE_SIZE & (PAGE_SIZE - 1U)) == 0U, "slab page size must be a power of two");
+  static_assert((GRANULE & (GRANULE - 1U)) == 0U, "slab granule must be a power of two");
+  static_assert(GRANULE >= 2U * sizeof(void*), "slab granule must hold two free list links");
+  static_assert(MAX_SIZE % GRANULE == 0U && NUM_CLASSES > 0U, "bad slab size classes");
+  static_assert(MAX_SIZE <= PAGE_SIZE, "slab page must hold at least one object");
+  static_assert(NUM_CLASSES < 0xFFU, "too many slab size classes");
+  static_assert(PAGE_SIZE / PAGE_ALIGN < 0xFFU, "slab page offsets must fit in a byte");
+  static_assert(PAGE_SIZE / GRANULE <= 0xFFU, "slab object counts must fit in a byte");
+
+  /**
+   * Returns true if the request is served by the slab rather than the mspace.
+   * Objects are aligned to GRANULE within their page, and the page to PAGE_ALIGN.
+   */
+  static constexpr bool is_small(std::size_t bytes, std::size_t alignment) noexcept {
+    return bytes <= MAX_SIZE && alignment <= GRANULE && alignment <= PAGE_ALIGN;
+  }
+
+  static constexpr std::size_t class_of(std::size_t bytes) noexcept {
+    return bytes == 0U ? 0U : (bytes - 1U) / GRANULE;
+  }
+
+  static constexpr std::size_t class_size(std::size_t cls) noexcept { return (cls + 1U) * GRANULE; }
+
+  constexpr slab_cache() noexcept
+      : base_(0U), free_(), spare_(), page_start_(), page_class_(), page_used_() {}
+
+  /**
+   * Bind the page table to the arena and forget every page.
+   */
+  void reset(const void* base) noexcept {
+    base_ = reinterpret_cast<uintptr_t>(base) & ~(PAGE_ALIGN - 1U);
+    free_.fill(nullptr);
+    spare_.fill(NO_PAGE);
+    page_start_.fill(0U);
+    page_class_.fill(0U);
+    page_used_.fill(0U);
+  }
+
+  void* allocate(std::size_t cls) noexcept {
+    auto node = free_[cls];
+    if (node == nullptr) {
+      return nullptr;
+    }
+    unlink(node, cls);
+    const auto page = lookup(node);
+    if (page_used_[page]++ == 0U && spare_[cls] == page) {
+      spare_[cls] = NO_PAGE;
+    }
+    return node;
+  }
+
+  /**
+   * Put p, an object of page (see lookup()), back on its free list. Returns the page if it has
+   * to go back to the mspace now, nullptr otherwise.
+   */
+  void* deallocate(void* p, std::size_t page) noexcept {
+    const auto cls = page_class(page);
+    push(p, cls);
+    if (--page_used_[page] != 0U) {
+      return nullptr;
+    } else if (spare_[cls] == NO_PAGE) {
+      spare_[cls] = page;
+      return nullptr;
+    }
+    return release(page);
+  }
+
+  /**
+   * Carve page, PAGE_SIZE bytes taken from the mspace, into objects of the class and put them on
+   * its free list.
+   */
+  void refill(void* page, std::size_t cls) noexcept {
+    const auto start = reinterpret_cast<uintptr_t>(page) - base_;
+    const auto index = start / PAGE_SIZE;
+    page_start_[index] = static_cast<uint8_t>(start % PAGE_SIZE / PAGE_ALIGN + 1U);
+    page_class_[index] = static_cast<uint8_t>(cls);
+    page_used_[index] = 0U;
+    const auto size = class_size(cls);
+    auto head = static_cast<uint8_t*>(page);
+    for (std::size_t off = (PAGE_SIZE / size - 1U) * size; off != 0U; off -= size) {
+      push(head + off, cls);
+    }
+    push(head, cls);
+  }
+
+  /**
+   * Take a spare page off its free list. Returns the page to give back to the mspace, or nullptr
+   * if no class has one.
+   */
+  void* release_spare() noexcept {
+    for (auto& page : spare_) {
+      if (page != NO_PAGE) {
+        const auto ret = page;
+        page = NO_PAGE;
+        return release(ret);
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Returns the page owning p, or NO_PAGE if p is not a slab object.
+   */
+  std::size_t lookup(const void* p) const noexcept {
+    const auto off = reinterpret_cast<uintptr_t>(p) - base_;
+    const auto index = off / PAGE_SIZE;
+    if (index >= NUM_PAGES) {
+      return NO_PAGE;
+    } else if (page_start_[index] != 0U && page_offset(index) <= off) {
+      return index;
+    } else if (index != 0U && page_start_[index - 1U] != 0U &&
+               off - page_offset(index - 1U) < PAGE_SIZE) {
+      return index - 1U;
+    }
+    return NO_PAGE;
+  }
+
+  std::size_t page_class(std::size_t page) const noexcept { return page_class_[page]; }
+
+private:
+  struct free_node {
+    free_node* next;
+    free_node* prev;
+  };
+
+  uintptr_t page_offset(std::size_t page) const noexcept {
+    return page * PAGE_SIZE + (page_start_[page] - 1U) * PAGE_ALIGN;
+  }
+
+  void push(void* p, std::size_t cls) noexcept {
+    auto node = static_cast<free_node*>(p);
+    node->next = free_[cls];
+    node->prev = nullptr;
+    if (node->next != nullptr) {
+      node->next->prev = node;
+    }
+    free_[cls] = node;
+  }
+
+  void unlink(free_node* node, std::size_t cls) noexcept {
+    if (node->prev == nullptr) {
+      free_[cls] = node->next;
+    } else {
+      node->prev->next = node->next;
+    }
+    if (node->next != nullptr) {
+      node->next->prev = node->prev;
+    }
+  }
+
+  /**
+   * Unlink every object of an empty page and drop it from the page table.
+   */
+  void* release(std::size_t page) noexcept {
+    const auto cls = page_class(page);
+    const auto size = class_size(cls);
+    auto head = reinterpret_cast<uint8_t*>(base_ + page_offset(page));
+    for (std::size_t off = 0U; off + size <= PAGE_SIZE; off += size) {
+      unlink(reinterpret_cast<free_node*>(head + off), cls);
+    }
+    page_start_[page] = 0U;
+    return head;
+  }
+
+  uintptr_t base_;
+  std::array<free_node*, NUM_CLASSES> free_;
+  std::array<std::size_t, NUM_CLASSES> spare_;
+  std::array<uint8_t, NUM_PAGES> page_start_;
+  std::array<uint8_t, NUM_PAGES> page_class_;
+  std::array<uint8_t, NUM_PAGES> page_used_;
+
+}; // class slab_cache
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_SLAB_CACHE_HXX
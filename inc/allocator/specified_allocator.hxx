@@ -6,17 +6,49 @@
 #ifndef FIREBALL_ALLOCATOR_SPECIFIED_ALLOCATOR_HXX
 #define FIREBALL_ALLOCATOR_SPECIFIED_ALLOCATOR_HXX
 
+#include <allocator/alloc_stats.hxx>
+#include <allocator/frag_report.hxx>
+#include <allocator/partition.hxx>
+#include <allocator/reclaimer.hxx>
+#include <allocator/slab_cache.hxx>
+#include <allocator/static_allocator.hxx>
 #include <array>
 #include <commons.hxx>
 #include <memory_resource>
+#include <tuple>
+#include <utils/backtrace.hxx>
 
 extern "C" {
 
 typedef void* mspace;
 extern void* create_mspace_with_base(void*, std::size_t, int);
 extern std::size_t destroy_mspace(mspace);
+extern void* mspace_malloc(mspace, std::size_t);
 extern void* mspace_memalign(mspace, std::size_t, std::size_t);
+extern void* mspace_realloc_in_place(mspace, void*, std::size_t);
 extern void mspace_free(mspace, void*);
+extern std::size_t mspace_bulk_free(mspace, void**, std::size_t);
+extern void** mspace_independent_comalloc(mspace, std::size_t, std::size_t*, void**);
+extern std::size_t mspace_usable_size(const void*);
+extern std::size_t mspace_footprint(mspace);
+extern std::size_t mspace_max_footprint(mspace);
+
+/**
+ * Layout of dlmalloc's struct mallinfo with MALLINFO_FIELD_TYPE=size_t.
+ */
+typedef struct {
+  std::size_t arena;
+  std::size_t ordblks;
+  std::size_t smblks;
+  std::size_t hblks;
+  std::size_t hblkhd;
+  std::size_t usmblks;
+  std::size_t fsmblks;
+  std::size_t uordblks;
+  std::size_t fordblks;
+  std::size_t keepcost;
+} mspace_mallinfo_t;
+extern mspace_mallinfo_t mspace_mallinfo(mspace);
 
 } // extern "C" {
 
@@ -33,6 +65,40 @@ namespace allocator {
  * The allocator manages fragmentation through dlmalloc's internal strategies and provides
  * O(log n) allocation/deallocation time complexity.
  *
+ * Requests of at most FIREBALL_SLAB_MAX_SIZE bytes are served by a slab_cache in front of the
+ * mspace in O(1) and without a chunk header per object. Slab pages are plain mspace chunks and
+ * go back to the mspace once empty (one spare per size class is kept until the mspace runs
+ * out). When the partition cannot provide another page a small request falls back to the
+ * mspace, so the slab never holds less than the mspace alone would. A sized deallocation
+ * (bytes != 0) of a block larger than the slab classes skips the page table; small blocks are
+ * always looked up, since they may come from either. Callers must pass either the allocation
+ * size or 0 (unknown) to deallocate().
+ *
+ * With FIREBALL_ALLOC_STATS enabled every instance keeps its own alloc_stats, see stats().
+ * fragmentation() walks the mspace on demand and tells a full partition from a fragmented one.
+ *
+ * Caches that may use the whole partition register reclaimers with add_reclaimer(). They run
+ * when an allocation fails, before nullptr is returned (and operator new gives up), after which
+ * the allocation is retried once. They also run when the usable bytes in use cross the soft
+ * limit set with set_soft_limit(), so caches shrink before the partition is actually full.
+ *
+ * The instance is constant-initialized (constinit), so instance() is a plain reference without
+ * the guard check of a function-local static, and the mspace is laid out by init() during boot
+ * (see init_partition_heaps()). An instance not initialized there does it on its first
+ * allocation.
+ *
+ * The arena is provided by arena_of(): a Tag naming a partition places it in partition_ram.
+ * On the native build (FIREBALL_VM_ARENA) blocks of at least FIREBALL_VM_RELEASE_THRESHOLD bytes
+ * give their pages back to the kernel when freed, and so does the whole arena on reset().
+ *
+ * Teardown of a whole partition (guest exit, service unload) does not need to free objects one
+ * by one: bulk_free() releases a batch of blocks and reset() drops everything in O(1) by
+ * re-creating the mspace in place.
+ *
+ * Related tables whose sizes are known together (e.g., the sections of a wasm module) can be
+ * co-allocated with comalloc(): one contiguous block split into arrays, released at once with
+ * bulk_free() or release_arrays().
+ *
  * Template Parameters:
  *   N   - Size of the arena in bytes (compile-time constant)
  *   Tag - Type tag for distinguishing multiple allocator instances
@@ -41,31 +107,253 @@ template <uint32_t N, typename Tag> struct specified_allocator : public std::pmr
 public:
   using this_type = specified_allocator;
 
-  static this_type& instance() {
-    static this_type inst;
-    return inst;
+  static this_type& instance() noexcept { return instance_; }
+
+  /**
+   * Lay out the mspace and the slab table in the arena. Does nothing if already done; fails
+   * silently, leaving every allocation to fail, if the arena is too small for an mspace.
+   */
+  void init() noexcept {
+    if (mspace_ != nullptr) {
+      return;
+    }
+    arena_ = arena_of<N, Tag>();
+    mspace_ = create_mspace_with_base(arena_, N, 0);
+    slab_.reset(arena_);
   }
 
   void* do_allocate(std::size_t bytes, std::size_t alignment) override {
-    return mspace_ == nullptr ? nullptr : mspace_memalign(mspace_, alignment, bytes);
+    const auto before = used_;
+    auto ret = try_allocate(bytes, alignment);
+    if (ret == nullptr && mspace_ == nullptr) {
+      // used before init_partition_heaps(), or not a partition heap: lay out the arena now.
+      init();
+      ret = try_allocate(bytes, alignment);
+    }
+    if (ret == nullptr && !reclaimers_.empty() && reclaimers_.run(bytes) != 0U) {
+      ret = try_allocate(bytes, alignment);
+    }
+    if (ret == nullptr) {
+      stats_.on_failure(bytes);
+    } else if (before <= soft_limit_ && used_ > soft_limit_) {
+      reclaimers_.run(used_ - soft_limit_);
+    }
+    return ret;
   }
 
-  void do_deallocate(void* p, [[maybe_unused]] std::size_t bytes,
-                     [[maybe_unused]] std::size_t alignment) override {
-    if (mspace_ != nullptr) {
-      mspace_free(mspace_, p);
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    if (p == nullptr || mspace_ == nullptr) {
+      // nothing.
+    } else if (bytes == 0U || slab_type::is_small(bytes, alignment)) {
+      // unsized or small: the page table tells a slab object from an mspace chunk.
+      const auto page = slab_.lookup(p);
+      if (page != slab_type::NO_PAGE) {
+        // a sized free must name the size the object was allocated with.
+        ASSERT_WITH_BACKTRACE(bytes == 0U ||
+                              slab_type::class_of(bytes) == slab_.page_class(page));
+        free_to_slab(p, page);
+      } else {
+        free_to_mspace(p);
+      }
+    } else {
+      // sized free of a large block: never a slab object, the page table is not consulted.
+      ASSERT_WITH_BACKTRACE(slab_.lookup(p) == slab_type::NO_PAGE);
+      free_to_mspace(p);
     }
   }
 
   bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
 
+  /**
+   * Free n blocks at once and set every entry to nullptr. Slab blocks go back to their free lists,
+   * the others to mspace_bulk_free, which merges chunks that are adjacent in the array (sorting
+   * the array by address helps). Returns the number of blocks that could not be freed.
+   */
+  std::size_t bulk_free(void* ptrs[], std::size_t n) noexcept {
+    if (mspace_ == nullptr) {
+      return n;
+    }
+    for (std::size_t i = 0U; i < n; ++i) {
+      std::size_t page;
+      if (ptrs[i] == nullptr) {
+        // nothing.
+      } else if ((page = slab_.lookup(ptrs[i])) != slab_type::NO_PAGE) {
+        free_to_slab(ptrs[i], page);
+        ptrs[i] = nullptr;
+      } else {
+        const auto usable = mspace_usable_size(ptrs[i]);
+        on_deallocate(usable);
+        if (usable >= FIREBALL_VM_RELEASE_THRESHOLD) {
+          release_pages(ptrs[i], usable);
+        }
+      }
+    }
+    return mspace_bulk_free(mspace_, ptrs, n);
+  }
+
+  /**
+   * Allocate n arrays of sizes[i] bytes adjacently with mspace_independent_comalloc and store
+   * them in chunks. Arrays are aligned to the mspace alignment (alignof(std::max_align_t)) and
+   * never come from the slab, so free them with bulk_free() or deallocate(p, 0), not with a
+   * sized deallocate. Returns false (chunks untouched) if the partition has no room even after
+   * running the reclaimers.
+   */
+  bool comalloc(std::size_t n, std::size_t sizes[], void* chunks[]) noexcept {
+    init();
+    if (mspace_ == nullptr) {
+      stats_.on_failure(0U);
+      return false;
+    }
+    if (mspace_independent_comalloc(mspace_, n, sizes, chunks) == nullptr) {
+      std::size_t total = 0U;
+      for (std::size_t i = 0U; i < n; ++i) {
+        total += sizes[i];
+      }
+      if (reclaimers_.empty() || reclaimers_.run(total) == 0U ||
+          mspace_independent_comalloc(mspace_, n, sizes, chunks) == nullptr) {
+        stats_.on_failure(0U);
+        return false;
+      }
+    }
+    for (std::size_t i = 0U; i < n; ++i) {
+      on_allocate(sizes[i], mspace_usable_size(chunks[i]));
+    }
+    return true;
+  }
+
+  /**
+   * Typed comalloc(): allocate counts[i] elements of every Ts in one block. Returns a tuple of
+   * nullptr on failure.
+   */
+  template <typename... Ts>
+  std::tuple<Ts*...>
+  comalloc_arrays(const std::array<std::size_t, sizeof...(Ts)>& counts) noexcept {
+    static_assert(((alignof(Ts) <= alignof(std::max_align_t)) && ...),
+                  "comalloc arrays are only aligned to std::max_align_t");
+    constexpr std::size_t sizes_of[] = {sizeof(Ts)...};
+    std::array<std::size_t, sizeof...(Ts)> sizes;
+    for (std::size_t i = 0U; i < sizeof...(Ts); ++i) {
+      sizes[i] = counts[i] * sizes_of[i];
+    }
+    std::array<void*, sizeof...(Ts)> chunks = {};
+    if (!comalloc(sizeof...(Ts), sizes.data(), chunks.data())) {
+      return {};
+    }
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return std::tuple<Ts*...>(static_cast<Ts*>(chunks[I])...);
+    }(std::index_sequence_for<Ts...>());
+  }
+
+  /**
+   * Release arrays obtained from comalloc_arrays() in one call.
+   */
+  template <typename... Ts> void release_arrays(Ts*... arrays) noexcept {
+    void* chunks[] = {static_cast<void*>(arrays)...};
+    bulk_free(chunks, sizeof...(Ts));
+  }
+
+  /**
+   * Drop every block of the partition, including the slab pages. Outstanding pointers into the
+   * arena become invalid.
+   */
+  void reset() noexcept {
+    if (mspace_ != nullptr) {
+      destroy_mspace(mspace_);
+      mspace_ = nullptr;
+      vm_release(arena_, N);
+    }
+    init();
+    used_ = 0U;
+    stats_.on_reset(0U);
+  }
+
+  /**
+   * Grow or shrink the block p to new_bytes without moving it (mspace_realloc_in_place). A slab
+   * block can only change size within its size class. Returns false if the block stays as it
+   * is; otherwise later sized deallocations must pass new_bytes.
+   */
+  bool expand(void* p, [[maybe_unused]] std::size_t old_bytes, std::size_t new_bytes) noexcept {
+    std::size_t page;
+    if (mspace_ == nullptr || p == nullptr) {
+      return false;
+    } else if ((page = slab_.lookup(p)) != slab_type::NO_PAGE) {
+      return new_bytes != 0U && slab_type::class_of(new_bytes) == slab_.page_class(page);
+    }
+    const auto before = mspace_usable_size(p);
+    if (mspace_realloc_in_place(mspace_, p, new_bytes) == nullptr) {
+      return false;
+    }
+    on_deallocate(before);
+    on_allocate(new_bytes, mspace_usable_size(p));
+    return true;
+  }
+
+  /**
+   * Register a reclaimer run on allocation failure and on crossing the soft limit. Returns false
+   * if FIREBALL_MAX_RECLAIMERS are already registered.
+   */
+  bool add_reclaimer(reclaim_fn fn, void* arg) noexcept { return reclaimers_.add(fn, arg); }
+
+  void remove_reclaimer(reclaim_fn fn, void* arg) noexcept { reclaimers_.remove(fn, arg); }
+
+  /**
+   * High-water mark in usable bytes; crossing it runs the reclaimers. Defaults to N (never).
+   */
+  void set_soft_limit(std::size_t bytes) noexcept { soft_limit_ = bytes; }
+
+  std::size_t soft_limit() const noexcept { return soft_limit_; }
+
+  /**
+   * Usable bytes of the blocks in use (slab class sizes and mspace chunk payloads).
+   */
+  std::size_t used() const noexcept { return used_; }
+
+  const uint8_t* begin() const noexcept { return arena_; }
+
+  const uint8_t* end() const noexcept { return arena_ + N; }
+
+  /**
+   * Statistics of this instance; all zero when FIREBALL_ALLOC_STATS is disabled.
+   */
+  alloc_stats stats() const noexcept {
+    alloc_stats ret = stats_.get();
+    if constexpr (stats_type::ENABLED) {
+      if (mspace_ != nullptr) {
+        ret.footprint = mspace_footprint(mspace_);
+        ret.max_footprint = mspace_max_footprint(mspace_);
+        ret.free_bytes = mspace_mallinfo(mspace_).fordblks;
+      }
+    }
+    return ret;
+  }
+
+  /**
+   * Fragmentation report of the mspace (free chunk histogram, largest free block, used/free map).
+   */
+  frag_report fragmentation() const noexcept {
+    return inspect_fragmentation(mspace_, arena_, arena_ + N);
+  }
+
   template <typename T> struct allocator : public std::pmr::polymorphic_allocator<T> {
+    using resource_type = this_type;
+
     allocator() : std::pmr::polymorphic_allocator<T>(&this_type::instance()) {}
   };
 
+  /**
+   * Allocator calling this heap directly instead of through std::pmr::memory_resource.
+   */
+  template <typename T>
+  using static_allocator = fireball::allocator::static_allocator<T, this_type>;
+
 private:
-  specified_allocator() : std::pmr::memory_resource(), arena_() {
-    mspace_ = create_mspace_with_base(arena_, N, 0);
+  using slab_type = slab_cache<N>;
+  using stats_type = default_stats_recorder;
+
+  constexpr specified_allocator() noexcept
+      : std::pmr::memory_resource(), mspace_(nullptr), slab_(), stats_(), reclaimers_(), used_(0U),
+        soft_limit_(N), arena_(constant_arena_of<N, Tag>()) {
+    // nothing.
   }
 
   ~specified_allocator() {
@@ -75,11 +363,113 @@ private:
     }
   }
 
+  void* try_allocate(std::size_t bytes, std::size_t alignment) noexcept {
+    void* ret = nullptr;
+    if (mspace_ == nullptr) {
+      // nothing.
+    } else if (slab_type::is_small(bytes, alignment)) {
+      const auto cls = slab_type::class_of(bytes);
+      ret = slab_.allocate(cls);
+      if (ret == nullptr) {
+        ret = refill(cls);
+      }
+      if (ret != nullptr) {
+        on_allocate(bytes, slab_type::class_size(cls));
+      } else {
+        // no room left for another slab page: the object alone may still fit in the mspace.
+        ret = allocate_from_mspace(bytes, alignment);
+      }
+    } else {
+      ret = allocate_from_mspace(bytes, alignment);
+    }
+    return ret;
+  }
+
+  void* allocate_from_mspace(std::size_t bytes, std::size_t alignment) noexcept {
+    auto ret = mspace_memalign(mspace_, alignment, bytes);
+    while (ret == nullptr && release_spare()) {
+      ret = mspace_memalign(mspace_, alignment, bytes);
+    }
+    if (ret != nullptr) {
+      on_allocate(bytes, mspace_usable_size(ret));
+    }
+    return ret;
+  }
+
+  void on_allocate(std::size_t bytes, std::size_t usable) noexcept {
+    used_ += usable;
+    stats_.on_allocate(bytes, usable);
+  }
+
+  void on_deallocate(std::size_t usable) noexcept {
+    used_ -= usable;
+    stats_.on_deallocate(usable);
+  }
+
+  /**
+   * Give the pages of a large block back before freeing it. The first bytes hold dlmalloc's
+   * free-chunk links and the last word the boundary tag of the next chunk, so they are kept.
+   */
+  static void release_pages(void* p, std::size_t usable) noexcept {
+    constexpr std::size_t LINKS = sizeof(void*) * 8U;
+    vm_release(static_cast<uint8_t*>(p) + LINKS, usable - LINKS - sizeof(std::size_t));
+  }
+
+  void free_to_slab(void* p, std::size_t page) noexcept {
+    on_deallocate(slab_type::class_size(slab_.page_class(page)));
+    auto empty = slab_.deallocate(p, page);
+    if (empty != nullptr) {
+      mspace_free(mspace_, empty);
+    }
+  }
+
+  void free_to_mspace(void* p) noexcept {
+    const auto usable = mspace_usable_size(p);
+    on_deallocate(usable);
+    if (usable >= FIREBALL_VM_RELEASE_THRESHOLD) {
+      release_pages(p, usable);
+    }
+    mspace_free(mspace_, p);
+  }
+
+  /**
+   * Give one spare slab page back to the mspace. Returns false if there was none.
+   */
+  bool release_spare() noexcept {
+    auto page = slab_.release_spare();
+    if (page == nullptr) {
+      return false;
+    }
+    mspace_free(mspace_, page);
+    return true;
+  }
+
+  void* refill(std::size_t cls) noexcept {
+    auto page = mspace_malloc(mspace_, slab_type::PAGE_SIZE);
+    while (page == nullptr && release_spare()) {
+      page = mspace_malloc(mspace_, slab_type::PAGE_SIZE);
+    }
+    if (page == nullptr) {
+      return nullptr;
+    }
+    slab_.refill(page, cls);
+    return slab_.allocate(cls);
+  }
+
   void* mspace_;
-  uint8_t arena_[N];
+  slab_type slab_;
+  [[no_unique_address]] stats_type stats_;
+  reclaimer_list reclaimers_;
+  std::size_t used_;
+  std::size_t soft_limit_;
+  uint8_t* arena_;
 
+  static constinit this_type instance_;
 }; // struct specified_allocator : public std::pmr::memory_resource {
 
+template <uint32_t N, typename Tag>
+constinit specified_allocator<N, Tag> specified_allocator<N, Tag>::instance_;
+
 } // namespace allocator
 } // namespace fireball
 
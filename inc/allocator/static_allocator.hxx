@@ -0,0 +1,83 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_STATIC_ALLOCATOR_HXX
+#define FIREBALL_ALLOCATOR_STATIC_ALLOCATOR_HXX
+
+#include <commons.hxx>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * static_allocator - Stateless allocator bound at compile time to the singleton of a heap.
+ *
+ * The allocator<T> of a heap derives from std::pmr::polymorphic_allocator, so every allocation
+ * of a container goes through the virtual do_allocate of std::pmr::memory_resource, which the
+ * compiler cannot inline even though the heap is fixed by its type. static_allocator names the
+ * heap in its type instead and calls Resource::do_allocate with a qualified name, which is a
+ * direct call: bump_allocator's allocation inlines into the container, and the others lose the
+ * indirect branch. Being empty, it also takes no room in the container.
+ *
+ * How much that saves depends on the heap (bench/static_allocator_bench.cxx on the dev host):
+ * std::list push/destroy runs 1.3-1.5x faster on bump_allocator, where the whole allocation
+ * inlines, but only 1.0-1.2x on specified_allocator, and std::map churn on specified_allocator
+ * shows no measurable difference (0.96-1.05x), the dlmalloc path dwarfing the saved call.
+ *
+ * Use it where the heap is known at compile time; keep allocator<T> where containers of
+ * different heaps must share one type. Like allocator<T>, allocate() returns nullptr when the
+ * heap is full instead of throwing, which the try_ functions of fireball containers expect.
+ *
+ *   container::growable_vector<uint32_t, spec_heap::static_allocator<uint32_t>> v;
+ *
+ * Template Parameters:
+ *   T        - Element type
+ *   Resource - Heap with a static instance() and public do_allocate/do_deallocate, e.g.
+ *              specified_allocator<N, Tag>
+ */
+template <typename T, typename Resource> struct static_allocator {
+  using value_type = T;
+  using resource_type = Resource;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::true_type;
+
+  template <typename U> struct rebind {
+    using other = static_allocator<U, Resource>;
+  };
+
+  constexpr static_allocator() noexcept = default;
+
+  template <typename U>
+  constexpr static_allocator([[maybe_unused]] const static_allocator<U, Resource>& other) noexcept {
+    // nothing.
+  }
+
+  [[nodiscard]] T* allocate(std::size_t n) {
+    if (n > SIZE_MAX / sizeof(T)) {
+      return nullptr;
+    }
+    return static_cast<T*>(Resource::instance().Resource::do_allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    Resource::instance().Resource::do_deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U>
+  constexpr bool
+  operator==([[maybe_unused]] const static_allocator<U, Resource>& other) const noexcept {
+    return true;
+  }
+}; // struct static_allocator
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_STATIC_ALLOCATOR_HXX
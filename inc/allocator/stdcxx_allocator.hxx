@@ -18,9 +18,11 @@ namespace allocator {
  *
  * This tag distinguishes the C++ standard library allocator instance from other
  * specified_allocator instances in the system. It enables compile-time differentiation
- * of allocator instances while maintaining type safety.
+ * of allocator instances while maintaining type safety. Its arena is the host partition.
  */
-struct stdcxx_allocator_tag {};
+struct stdcxx_allocator_tag {
+  static constexpr partition_id partition = partition_id::host;
+};
 
 /**
  * stdcxx_allocator - Global allocator for C++ standard library containers.
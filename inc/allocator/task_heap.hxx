@@ -0,0 +1,116 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_TASK_HEAP_HXX
+#define FIREBALL_ALLOCATOR_TASK_HEAP_HXX
+
+#include <allocator/current_core.hxx>
+#include <allocator/frag_report.hxx>
+#include <allocator/remote_free_queue.hxx>
+#include <array>
+#include <commons.hxx>
+#include <memory_resource>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * task_heap - Memory resource of a COOS task (co_mem) and the arena it covers.
+ *
+ * The scheduler of each core switches that core's current task heap on every context switch,
+ * and the global operator new allocates from the heap of the calling core. The arena range lets
+ * operator delete return a block to the heap that owns it even when another task frees it
+ * (e.g., after a co_value ownership move). fragmentation is set for allocators that can report
+ * it and is printed when operator new runs out of memory.
+ *
+ * Tasks do not migrate: a heap belongs to the core that describes it with of() and is only made
+ * current there. The resource is not locked, so a block freed on another core is pushed onto
+ * remote_frees and returned to the resource by the owner core on its next operator new from it.
+ */
+struct task_heap {
+  std::pmr::memory_resource* resource;
+  const uint8_t* begin;
+  const uint8_t* end;
+  frag_report (*fragmentation)(const std::pmr::memory_resource&);
+  uint32_t core;
+  remote_free_queue remote_frees;
+
+  bool contains(const void* p) const noexcept {
+    const auto q = static_cast<const uint8_t*>(p);
+    return begin <= q && q < end;
+  }
+
+  /**
+   * Return the blocks freed by other cores to the resource. Called on the owner core only.
+   */
+  void drain_remote_frees() noexcept {
+    auto n = remote_frees.take_all();
+    while (n != nullptr) {
+      auto next = n->next;
+      resource->deallocate(n, 0U);
+      n = next;
+    }
+  }
+
+  /**
+   * Describe an allocator that exposes its arena through begin()/end().
+   */
+  template <typename A> static task_heap of(A& a) noexcept {
+    if constexpr (requires { a.init(); }) {
+      // an arena reserved at run time has no address before init().
+      a.init();
+    }
+    if constexpr (requires { a.fragmentation(); }) {
+      return {&a, a.begin(), a.end(),
+              [](const std::pmr::memory_resource& r) {
+                return static_cast<const A&>(r).fragmentation();
+              },
+              current_core(), {}};
+    } else {
+      return {&a, a.begin(), a.end(), nullptr, current_core(), {}};
+    }
+  }
+};
+
+namespace detail {
+extern std::array<task_heap*, FIREBALL_CORE_COUNT> current_task_heaps;
+} // namespace detail
+
+/**
+ * Heap of the task running on the calling core, or nullptr when no task is running there.
+ */
+inline task_heap* current_task_heap() noexcept {
+  return detail::current_task_heaps[current_core()];
+}
+
+/**
+ * Make heap the current task heap of the calling core (nullptr falls back to the stdcxx heap).
+ * Called by the scheduler of the core when it resumes or suspends a task.
+ */
+inline void switch_task_heap(task_heap* heap) noexcept {
+  detail::current_task_heaps[current_core()] = heap;
+}
+
+/**
+ * Register a task heap so that blocks freed outside of its task find their owner.
+ * The heap must cover whole FIREBALL_PARTITION_GRANULE units of partition_ram. Returns false if
+ * it does not or if FIREBALL_MAX_TASKS heaps are already registered.
+ */
+extern bool register_task_heap(task_heap* heap) noexcept;
+
+/**
+ * Unregister a task heap, e.g. when its task exits. It stops being the current heap of any core.
+ */
+extern void unregister_task_heap(task_heap* heap) noexcept;
+
+/**
+ * Find the registered task heap owning p in O(1), or nullptr.
+ */
+extern task_heap* find_task_heap(const void* p) noexcept;
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_TASK_HEAP_HXX
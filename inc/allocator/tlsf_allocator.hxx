@@ -0,0 +1,345 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_TLSF_ALLOCATOR_HXX
+#define FIREBALL_ALLOCATOR_TLSF_ALLOCATOR_HXX
+
+#include <allocator/alloc_stats.hxx>
+#include <allocator/partition.hxx>
+#include <allocator/static_allocator.hxx>
+#include <array>
+#include <bit>
+#include <commons.hxx>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * tlsf_allocator - Two-level segregated fit allocator with O(1) worst-case latency.
+ *
+ * Free blocks are kept in FL x SL segregated lists: the first level splits sizes by powers of
+ * two, the second level splits each power of two linearly into SL_COUNT ranges. Two bitmaps
+ * record which lists are non-empty, so finding a fitting block, splitting it, and merging a
+ * freed block with its physical neighbours all take a constant number of steps with no list
+ * scan. This bounds allocation and deallocation latency for real-time guests, at the cost of
+ * some internal fragmentation from rounding requests up to the next list.
+ *
+ * Every block starts with a header holding the previous physical block and the payload size;
+ * free blocks also hold the links of their segregated list in the payload. A zero-sized used
+ * sentinel ends the arena so merging never runs past it.
+ *
+ * It offers the same instance()/allocator<T> surface as specified_allocator, and a Tag naming
+ * a partition places its arena in partition_ram. Like specified_allocator, the instance is
+ * constinit and init() lays out the arena during boot, or at the first allocation otherwise.
+ *
+ * Template Parameters:
+ *   N   - Size of the arena in bytes (compile-time constant)
+ *   Tag - Type tag for distinguishing multiple allocator instances
+ */
+template <uint32_t N, typename Tag> struct tlsf_allocator : public std::pmr::memory_resource {
+public:
+  using this_type = tlsf_allocator;
+
+  static this_type& instance() noexcept { return instance_; }
+
+  /**
+   * Make the whole arena one free block. Does nothing if already done.
+   */
+  void init() noexcept {
+    if (ready_) {
+      return;
+    }
+    ready_ = true;
+    arena_ = arena_of<N, Tag>();
+    const auto base = (reinterpret_cast<uintptr_t>(arena_) + ALIGN - 1U) & ~(uintptr_t)(ALIGN - 1U);
+    const auto limit = (reinterpret_cast<uintptr_t>(arena_) + N) & ~(uintptr_t)(ALIGN - 1U);
+    auto first = reinterpret_cast<block_header*>(base);
+    first->prev_phys = nullptr;
+    first->size_and_flags = (limit - base - 2U * HEADER) | block_header::FREE_BIT;
+    auto sentinel = next_of(first);
+    sentinel->prev_phys = first;
+    sentinel->size_and_flags = 0U;
+    insert(first);
+  }
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (bytes > N || alignment > N) {
+      // neither fits; rejecting them first also keeps the size arithmetic below from wrapping.
+      stats_.on_failure(bytes);
+      return nullptr;
+    }
+    auto b = alignment <= ALIGN ? take(adjust(bytes)) : take_aligned(adjust(bytes), alignment);
+    if (b == nullptr && !ready_) {
+      // used before init_partition_heaps(), or not a partition heap: lay out the arena now.
+      init();
+      return this_type::do_allocate(bytes, alignment);
+    }
+    if (b == nullptr) {
+      stats_.on_failure(bytes);
+      return nullptr;
+    }
+    stats_.on_allocate(bytes, b->size());
+    return payload_of(b);
+  }
+
+  void do_deallocate(void* p, [[maybe_unused]] std::size_t bytes,
+                     [[maybe_unused]] std::size_t alignment) override {
+    if (p == nullptr) {
+      return;
+    }
+    auto b = block_of(p);
+    stats_.on_deallocate(b->size());
+    b->set_free(true);
+    auto prev = b->prev_phys;
+    if (prev != nullptr && prev->is_free()) {
+      remove(prev);
+      b = merge(prev, b);
+    }
+    auto next = next_of(b);
+    if (next->is_free()) {
+      remove(next);
+      b = merge(b, next);
+    }
+    insert(b);
+  }
+
+  bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+
+  const uint8_t* begin() const noexcept { return arena_; }
+
+  const uint8_t* end() const noexcept { return arena_ + N; }
+
+  /**
+   * Statistics of this instance; all zero when FIREBALL_ALLOC_STATS is disabled.
+   */
+  alloc_stats stats() const noexcept { return stats_.get(); }
+
+  template <typename T> struct allocator : public std::pmr::polymorphic_allocator<T> {
+    allocator() : std::pmr::polymorphic_allocator<T>(&this_type::instance()) {}
+  };
+
+  /**
+   * Allocator calling this heap directly instead of through std::pmr::memory_resource.
+   */
+  template <typename T>
+  using static_allocator = fireball::allocator::static_allocator<T, this_type>;
+
+private:
+  static constexpr std::size_t ALIGN = alignof(std::max_align_t);
+  static constexpr std::size_t ALIGN_LOG2 = std::countr_zero(ALIGN);
+  static constexpr std::size_t SL_LOG2 = 4U;
+  static constexpr std::size_t SL_COUNT = 1U << SL_LOG2;
+  static constexpr std::size_t FL_SHIFT = SL_LOG2 + ALIGN_LOG2;
+  static constexpr std::size_t SMALL_BLOCK = 1U << FL_SHIFT;
+  static constexpr std::size_t FL_COUNT = std::bit_width(N) - FL_SHIFT + 1U;
+
+  static_assert(N > SMALL_BLOCK, "tlsf arena is too small");
+
+  struct block_header {
+    static constexpr std::size_t FREE_BIT = 1U;
+
+    block_header* prev_phys;
+    std::size_t size_and_flags;
+    // the following links exist only while the block is free.
+    block_header* next_free;
+    block_header* prev_free;
+
+    std::size_t size() const noexcept { return size_and_flags & ~FREE_BIT; }
+    bool is_free() const noexcept { return (size_and_flags & FREE_BIT) != 0U; }
+    void set_size(std::size_t size) noexcept {
+      size_and_flags = size | (size_and_flags & FREE_BIT);
+    }
+    void set_free(bool free) noexcept { size_and_flags = size() | (free ? FREE_BIT : 0U); }
+  };
+
+  static constexpr std::size_t HEADER = offsetof(block_header, next_free);
+  static constexpr std::size_t MIN_BLOCK = sizeof(block_header) - HEADER;
+
+  static_assert(HEADER % ALIGN == 0U, "tlsf block header must keep payloads aligned");
+  static_assert(N <= SIZE_MAX / 4U, "tlsf arena too large for its size arithmetic");
+
+  static std::size_t adjust(std::size_t bytes) noexcept {
+    const auto size = (bytes + ALIGN - 1U) & ~(ALIGN - 1U);
+    return size < MIN_BLOCK ? MIN_BLOCK : size;
+  }
+
+  static void* payload_of(block_header* b) noexcept {
+    return reinterpret_cast<uint8_t*>(b) + HEADER;
+  }
+
+  static block_header* block_of(void* p) noexcept {
+    return reinterpret_cast<block_header*>(static_cast<uint8_t*>(p) - HEADER);
+  }
+
+  static block_header* next_of(block_header* b) noexcept {
+    return reinterpret_cast<block_header*>(reinterpret_cast<uint8_t*>(b) + HEADER + b->size());
+  }
+
+  /**
+   * List of a free block of the given size.
+   */
+  static void mapping(std::size_t size, std::size_t& fl, std::size_t& sl) noexcept {
+    if (size < SMALL_BLOCK) {
+      fl = 0U;
+      sl = size >> ALIGN_LOG2;
+    } else {
+      const auto log2 = static_cast<std::size_t>(std::bit_width(size)) - 1U;
+      sl = (size >> (log2 - SL_LOG2)) ^ SL_COUNT;
+      fl = log2 - FL_SHIFT + 1U;
+    }
+  }
+
+  /**
+   * First list whose blocks are all at least size bytes.
+   */
+  static void mapping_search(std::size_t size, std::size_t& fl, std::size_t& sl) noexcept {
+    if (size >= SMALL_BLOCK) {
+      size += (std::size_t(1U) << (std::bit_width(size) - 1U - SL_LOG2)) - 1U;
+    }
+    mapping(size, fl, sl);
+  }
+
+  void insert(block_header* b) noexcept {
+    std::size_t fl, sl;
+    mapping(b->size(), fl, sl);
+    auto head = free_[fl][sl];
+    b->next_free = head;
+    b->prev_free = nullptr;
+    if (head != nullptr) {
+      head->prev_free = b;
+    }
+    free_[fl][sl] = b;
+    fl_bitmap_ |= 1U << fl;
+    sl_bitmap_[fl] |= 1U << sl;
+  }
+
+  void remove(block_header* b) noexcept {
+    std::size_t fl, sl;
+    mapping(b->size(), fl, sl);
+    if (b->prev_free != nullptr) {
+      b->prev_free->next_free = b->next_free;
+    } else {
+      free_[fl][sl] = b->next_free;
+    }
+    if (b->next_free != nullptr) {
+      b->next_free->prev_free = b->prev_free;
+    }
+    if (free_[fl][sl] == nullptr) {
+      sl_bitmap_[fl] &= ~(1U << sl);
+      if (sl_bitmap_[fl] == 0U) {
+        fl_bitmap_ &= ~(1U << fl);
+      }
+    }
+  }
+
+  /**
+   * Merge the physical neighbours a and b (a before b) into a.
+   */
+  static block_header* merge(block_header* a, block_header* b) noexcept {
+    a->set_size(a->size() + HEADER + b->size());
+    next_of(a)->prev_phys = a;
+    return a;
+  }
+
+  /**
+   * Cut the tail of b beyond size bytes into a free block if it is large enough.
+   */
+  void split(block_header* b, std::size_t size) noexcept {
+    if (b->size() < size + HEADER + MIN_BLOCK) {
+      return;
+    }
+    auto rest = reinterpret_cast<block_header*>(reinterpret_cast<uint8_t*>(b) + HEADER + size);
+    rest->size_and_flags = (b->size() - size - HEADER) | block_header::FREE_BIT;
+    rest->prev_phys = b;
+    next_of(rest)->prev_phys = rest;
+    b->set_size(size);
+    insert(rest);
+  }
+
+  /**
+   * Remove a free block of at least size bytes from its list, or return nullptr.
+   */
+  block_header* find(std::size_t size) noexcept {
+    std::size_t fl, sl;
+    mapping_search(size, fl, sl);
+    if (fl >= FL_COUNT) {
+      return nullptr;
+    }
+    auto sl_map = sl_bitmap_[fl] & (~0U << sl);
+    if (sl_map == 0U) {
+      const auto fl_map = fl + 1U < 32U ? fl_bitmap_ & (~0U << (fl + 1U)) : 0U;
+      if (fl_map == 0U) {
+        return nullptr;
+      }
+      fl = static_cast<std::size_t>(std::countr_zero(fl_map));
+      sl_map = sl_bitmap_[fl];
+    }
+    sl = static_cast<std::size_t>(std::countr_zero(sl_map));
+    auto b = free_[fl][sl];
+    remove(b);
+    return b;
+  }
+
+  block_header* take(std::size_t size) noexcept {
+    auto b = find(size);
+    if (b != nullptr) {
+      split(b, size);
+      b->set_free(false);
+    }
+    return b;
+  }
+
+  block_header* take_aligned(std::size_t size, std::size_t alignment) noexcept {
+    auto b = find(size + alignment + HEADER + MIN_BLOCK);
+    if (b == nullptr) {
+      return nullptr;
+    }
+    const auto payload = reinterpret_cast<uintptr_t>(payload_of(b));
+    auto aligned = (payload + alignment - 1U) & ~(uintptr_t)(alignment - 1U);
+    if (aligned != payload && aligned - payload < HEADER + MIN_BLOCK) {
+      aligned = (payload + HEADER + MIN_BLOCK + alignment - 1U) & ~(uintptr_t)(alignment - 1U);
+    }
+    if (aligned != payload) {
+      // give the leading gap back as a free block of its own.
+      const auto gap = aligned - payload;
+      auto head = reinterpret_cast<block_header*>(reinterpret_cast<uint8_t*>(b) + gap);
+      head->size_and_flags = b->size() - gap;
+      head->prev_phys = b;
+      next_of(head)->prev_phys = head;
+      b->size_and_flags = (gap - HEADER) | block_header::FREE_BIT;
+      insert(b);
+      b = head;
+    }
+    split(b, size);
+    b->set_free(false);
+    return b;
+  }
+
+  constexpr tlsf_allocator() noexcept
+      : std::pmr::memory_resource(), fl_bitmap_(0U), sl_bitmap_(), free_(), stats_(),
+        arena_(constant_arena_of<N, Tag>()), ready_(false) {
+    // nothing.
+  }
+
+  uint32_t fl_bitmap_;
+  std::array<uint32_t, FL_COUNT> sl_bitmap_;
+  std::array<std::array<block_header*, SL_COUNT>, FL_COUNT> free_;
+  [[no_unique_address]] default_stats_recorder stats_;
+  uint8_t* arena_;
+  bool ready_;
+
+  static constinit this_type instance_;
+}; // struct tlsf_allocator : public std::pmr::memory_resource
+
+template <uint32_t N, typename Tag>
+constinit tlsf_allocator<N, Tag> tlsf_allocator<N, Tag>::instance_;
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_TLSF_ALLOCATOR_HXX
@@ -0,0 +1,48 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_ALLOCATOR_VM_ARENA_HXX
+#define FIREBALL_ALLOCATOR_VM_ARENA_HXX
+
+#include <commons.hxx>
+#include <cstddef>
+
+namespace fireball {
+namespace allocator {
+
+/**
+ * Virtual memory backed arenas of the native build (FIREBALL_VM_ARENA).
+ *
+ * vm_reserve() maps address space without reserving swap for it (MAP_NORESERVE), so an arena
+ * costs nothing until its pages are touched, and vm_release() hands the pages of a block that
+ * is no longer used back to the kernel (MADV_DONTNEED). Released pages read as zero when they
+ * are touched again. On MCU targets the arenas are plain RAM and vm_release() does nothing.
+ */
+
+/**
+ * Reserve size bytes of address space, page aligned. Terminates if the mapping fails. Only
+ * defined with FIREBALL_VM_ARENA.
+ */
+extern uint8_t* vm_reserve(std::size_t size) noexcept;
+
+#if FIREBALL_VM_ARENA
+
+/**
+ * Give back the pages lying entirely inside [p, p + size); partial pages at either end are kept.
+ */
+extern void vm_release(void* p, std::size_t size) noexcept;
+
+#else
+
+inline void vm_release([[maybe_unused]] void* p, [[maybe_unused]] std::size_t size) noexcept {
+  // nothing.
+}
+
+#endif
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_ALLOCATOR_VM_ARENA_HXX
@@ -0,0 +1,175 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_CONTAINER_FLAT_MAP_HXX
+#define FIREBALL_CONTAINER_FLAT_MAP_HXX
+
+#include <algorithm>
+#include <array>
+#include <commons.hxx>
+#include <container/inplace_vector.hxx>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fireball {
+namespace container {
+
+/**
+ * flat_map - Small sorted key-value map over a key-value array and a sorted index array.
+ *
+ * Replacement of std::map/std::unordered_map for up to about a hundred elements, as described
+ * in docs/agent/patterns/stdlib.md: entries stay in insertion order in an inplace_vector and
+ * only the index array is kept sorted by key, so an insertion shifts small indices instead of
+ * whole entries. Lookups binary search the index with std::lower_bound.
+ *
+ * It is chosen for memory behaviour (no allocation per entry, so no fragmentation) and cheap
+ * updates, not for lookup speed: at about a hundred entries a lookup goes through the index and
+ * is slower than std::pmr::map in optimized builds (0.53-0.96x in bench/container_bench.cxx),
+ * while erase and re-insert run about twice as fast. For lookup-heavy tables whose keys do not
+ * change, use a sorted array or utils::perfect_hash_map instead.
+ *
+ * As in std::map, value_type is std::pair<const Key, T>, so a key cannot be changed in place,
+ * which would break the index.
+ *
+ * Erasing moves the last entry into the freed slot, so pointers to values stay valid across
+ * insertions but not across erasures. Iteration with begin()/end() is in storage order;
+ * at_rank(i) gives the i-th entry in key order.
+ *
+ * Template Parameters:
+ *   Key     - Key type
+ *   T       - Mapped type
+ *   N       - Capacity in entries (compile-time constant)
+ *   Compare - Strict weak ordering of the keys
+ */
+template <typename Key, typename T, std::size_t N, typename Compare = std::less<Key>>
+class flat_map {
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = std::size_t;
+  using iterator = value_type*;
+  using const_iterator = const value_type*;
+
+  flat_map() noexcept : entries_(), index_(), compare_() {}
+
+  /**
+   * Value of key, or nullptr.
+   */
+  T* find(const Key& key) noexcept {
+    const auto pos = lower_bound(key);
+    return pos != index_end() && !compare_(key, entries_[*pos].first) ? &entries_[*pos].second
+                                                                       : nullptr;
+  }
+
+  const T* find(const Key& key) const noexcept { return const_cast<flat_map*>(this)->find(key); }
+
+  bool contains(const Key& key) const noexcept { return find(key) != nullptr; }
+
+  /**
+   * Value of key, constructed from args if key is new. Returns nullptr if key is new and the
+   * map is full.
+   */
+  template <typename... Args> T* try_emplace(const Key& key, Args&&... args) {
+    const auto pos = lower_bound(key);
+    if (pos != index_end() && !compare_(key, entries_[*pos].first)) {
+      return &entries_[*pos].second;
+    }
+    const auto last = index_end();
+    const auto slot = static_cast<index_type>(entries_.size());
+    auto entry = entries_.try_emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                                           std::forward_as_tuple(std::forward<Args>(args)...));
+    if (entry == nullptr) {
+      return nullptr;
+    }
+    std::move_backward(pos, last, last + 1);
+    *pos = slot;
+    return &entry->second;
+  }
+
+  /**
+   * Insert or overwrite the value of key. Returns false if the map is full.
+   */
+  bool insert_or_assign(const Key& key, T value) {
+    auto ret = try_emplace(key);
+    if (ret == nullptr) {
+      return false;
+    }
+    *ret = std::move(value);
+    return true;
+  }
+
+  /**
+   * Remove key. Returns false if it was not present.
+   */
+  bool erase(const Key& key) {
+    const auto pos = lower_bound(key);
+    if (pos == index_end() || compare_(key, entries_[*pos].first)) {
+      return false;
+    }
+    const auto slot = *pos;
+    std::move(pos + 1, index_end(), pos);
+    const auto last = static_cast<index_type>(entries_.size() - 1U);
+    if (slot != last) {
+      // the key is const, so the last entry is constructed in place of the erased one.
+      std::destroy_at(&entries_[slot]);
+      std::construct_at(&entries_[slot], std::move(entries_[last]));
+      *std::find(index_.begin(), index_end() - 1, last) = slot;
+    }
+    entries_.pop_back();
+    return true;
+  }
+
+  void clear() noexcept { entries_.clear(); }
+
+  size_type size() const noexcept { return entries_.size(); }
+
+  static constexpr size_type capacity() noexcept { return N; }
+
+  bool empty() const noexcept { return entries_.empty(); }
+
+  bool full() const noexcept { return entries_.full(); }
+
+  /**
+   * The entry of rank i in key order.
+   */
+  const value_type& at_rank(size_type i) const noexcept { return entries_[index_[i]]; }
+
+  iterator begin() noexcept { return entries_.begin(); }
+
+  iterator end() noexcept { return entries_.end(); }
+
+  const_iterator begin() const noexcept { return entries_.begin(); }
+
+  const_iterator end() const noexcept { return entries_.end(); }
+
+private:
+  using index_type = std::conditional_t<(N <= 0xFFU), uint8_t, uint16_t>;
+
+  static_assert(N <= 0xFFFFU, "flat_map is meant for small maps");
+
+  typename std::array<index_type, N>::iterator index_end() noexcept {
+    return index_.begin() + entries_.size();
+  }
+
+  typename std::array<index_type, N>::iterator lower_bound(const Key& key) noexcept {
+    return std::lower_bound(index_.begin(), index_end(), key, [this](index_type i, const Key& k) {
+      return compare_(entries_[i].first, k);
+    });
+  }
+
+  inplace_vector<value_type, N> entries_;
+  std::array<index_type, N> index_;
+  [[no_unique_address]] Compare compare_;
+}; // class flat_map
+
+} // namespace container
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_CONTAINER_FLAT_MAP_HXX
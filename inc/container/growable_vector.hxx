@@ -0,0 +1,212 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_CONTAINER_GROWABLE_VECTOR_HXX
+#define FIREBALL_CONTAINER_GROWABLE_VECTOR_HXX
+
+#include <algorithm>
+#include <commons.hxx>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <utils/backtrace.hxx>
+
+namespace fireball {
+namespace container {
+
+/**
+ * Allocators of fireball heaps name their memory resource; growable_vector uses its expand()
+ * to grow a buffer in place.
+ */
+template <typename Alloc>
+concept expandable_allocator = requires(void* p, std::size_t n) {
+  { Alloc::resource_type::instance().expand(p, n, n) } -> std::same_as<bool>;
+};
+
+/**
+ * growable_vector - Vector with a heap buffer that grows in place when it can.
+ *
+ * For collections without a fixed upper bound, where std::vector is banned (see
+ * docs/agent/patterns/stdlib.md). When the buffer is full it first asks the allocator's
+ * resource to expand the block where it is, which specified_allocator does with
+ * mspace_realloc_in_place and bump_allocator does when the buffer is the last block of the
+ * arena. Only if that fails is a new buffer allocated and the elements moved, so a vector
+ * filled on its own rarely copies and leaves no hole behind.
+ *
+ * The gain in speed depends on the heap. Filling 16384 elements in optimized builds runs at
+ * 1.8-2.7x of std::pmr::vector on a bump_allocator, but only 0.9-1.4x on a
+ * specified_allocator (bench/container_bench.cxx), where the pushes dominate and growing in
+ * place saves little. Use it there to keep the arena unfragmented, not for speed.
+ *
+ * Allocation failures do not throw: try_ functions return nullptr or false and leave the
+ * vector unchanged. Copying is not supported because it could fail silently.
+ *
+ * Template Parameters:
+ *   T     - Element type
+ *   Alloc - Allocator, e.g. specified_allocator<N, Tag>::static_allocator<T>
+ */
+template <typename T, typename Alloc = std::pmr::polymorphic_allocator<T>> class growable_vector {
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  explicit growable_vector(const Alloc& alloc = Alloc()) noexcept
+      : alloc_(alloc), data_(nullptr), size_(0U), capacity_(0U) {}
+
+  growable_vector(growable_vector&& other) noexcept
+      : alloc_(other.alloc_), data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0U)), capacity_(std::exchange(other.capacity_, 0U)) {}
+
+  growable_vector(const growable_vector&) = delete;
+  growable_vector& operator=(const growable_vector&) = delete;
+
+  ~growable_vector() {
+    clear();
+    if (data_ != nullptr) {
+      traits::deallocate(alloc_, data_, capacity_);
+    }
+  }
+
+  /**
+   * Make room for n elements. Returns false if the allocator has no room or n * sizeof(T)
+   * does not fit in size_t.
+   */
+  bool reserve(size_type n) {
+    if (n <= capacity_) {
+      return true;
+    }
+    if (n > MAX_SIZE) {
+      return false;
+    }
+    if (expand_in_place(n)) {
+      return true;
+    }
+    auto p = traits::allocate(alloc_, n);
+    if (p == nullptr) {
+      return false;
+    }
+    relocate(p, n);
+    return true;
+  }
+
+  /**
+   * Construct an element at the end, doubling the buffer when it is full. Returns nullptr if
+   * the buffer cannot grow.
+   */
+  template <typename... Args> T* try_emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      const auto n =
+          capacity_ < MAX_SIZE / 2U ? std::max<size_type>(capacity_ * 2U, 4U) : MAX_SIZE;
+      if (n == capacity_) {
+        return nullptr;
+      }
+      if (!expand_in_place(n)) {
+        auto p = traits::allocate(alloc_, n);
+        if (p == nullptr) {
+          return nullptr;
+        }
+        // args may refer to an element: construct before the old buffer is released.
+        auto ret = std::construct_at(p + size_, std::forward<Args>(args)...);
+        relocate(p, n);
+        ++size_;
+        return ret;
+      }
+    }
+    auto ret = std::construct_at(data_ + size_, std::forward<Args>(args)...);
+    ++size_;
+    return ret;
+  }
+
+  T* try_push_back(const T& value) { return try_emplace_back(value); }
+
+  T* try_push_back(T&& value) { return try_emplace_back(std::move(value)); }
+
+  void pop_back() {
+    ASSERT_WITH_BACKTRACE(size_ != 0U);
+    --size_;
+    std::destroy_at(data_ + size_);
+  }
+
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    size_ = 0U;
+  }
+
+  size_type size() const noexcept { return size_; }
+
+  size_type capacity() const noexcept { return capacity_; }
+
+  bool empty() const noexcept { return size_ == 0U; }
+
+  T* data() noexcept { return data_; }
+
+  const T* data() const noexcept { return data_; }
+
+  T& operator[](size_type i) noexcept { return data_[i]; }
+
+  const T& operator[](size_type i) const noexcept { return data_[i]; }
+
+  T& back() noexcept { return data_[size_ - 1U]; }
+
+  iterator begin() noexcept { return data_; }
+
+  iterator end() noexcept { return data_ + size_; }
+
+  const_iterator begin() const noexcept { return data_; }
+
+  const_iterator end() const noexcept { return data_ + size_; }
+
+  operator std::span<T>() noexcept { return {data_, size_}; }
+
+  operator std::span<const T>() const noexcept { return {data_, size_}; }
+
+private:
+  using traits = std::allocator_traits<Alloc>;
+
+  static constexpr size_type MAX_SIZE = SIZE_MAX / sizeof(T);
+
+  /**
+   * Grow the buffer to n elements where it is, if the allocator can.
+   */
+  bool expand_in_place(size_type n) {
+    if constexpr (expandable_allocator<Alloc>) {
+      if (data_ != nullptr &&
+          Alloc::resource_type::instance().expand(data_, capacity_ * sizeof(T), n * sizeof(T))) {
+        capacity_ = n;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Move the elements to the buffer p of n elements and release the old one.
+   */
+  void relocate(T* p, size_type n) {
+    if (data_ != nullptr) {
+      std::uninitialized_move(begin(), end(), p);
+      std::destroy(begin(), end());
+      traits::deallocate(alloc_, data_, capacity_);
+    }
+    data_ = p;
+    capacity_ = n;
+  }
+
+  [[no_unique_address]] Alloc alloc_;
+  T* data_;
+  size_type size_;
+  size_type capacity_;
+}; // class growable_vector
+
+} // namespace container
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_CONTAINER_GROWABLE_VECTOR_HXX
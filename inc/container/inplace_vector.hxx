@@ -0,0 +1,184 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_CONTAINER_INPLACE_VECTOR_HXX
+#define FIREBALL_CONTAINER_INPLACE_VECTOR_HXX
+
+#include <commons.hxx>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+#include <utils/backtrace.hxx>
+
+namespace fireball {
+namespace container {
+
+/**
+ * inplace_vector - Vector with a fixed capacity and its elements stored inline.
+ *
+ * Replacement of std::vector (see docs/agent/patterns/stdlib.md) for collections with a known
+ * upper bound. It never allocates, so it lives wherever its owner lives: on the stack, in a
+ * static, or inside an object allocated from bump_allocator or specified_allocator. Unlike
+ * std::array the elements are constructed on demand and the size is tracked.
+ *
+ * Without exceptions a full vector cannot throw: the try_ functions return nullptr instead,
+ * and the plain ones assert in debug builds.
+ *
+ * Template Parameters:
+ *   T - Element type
+ *   N - Capacity in elements (compile-time constant)
+ */
+template <typename T, std::size_t N> class inplace_vector {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  static_assert(N > 0U, "inplace_vector needs a capacity");
+
+  inplace_vector() noexcept : size_(0U) {}
+
+  inplace_vector(const inplace_vector& other) : size_(0U) {
+    for (const auto& e : other) {
+      emplace_back(e);
+    }
+  }
+
+  inplace_vector(inplace_vector&& other) noexcept : size_(0U) {
+    for (auto& e : other) {
+      emplace_back(std::move(e));
+    }
+    other.clear();
+  }
+
+  inplace_vector& operator=(const inplace_vector& other) {
+    if (this != &other) {
+      clear();
+      for (const auto& e : other) {
+        emplace_back(e);
+      }
+    }
+    return *this;
+  }
+
+  inplace_vector& operator=(inplace_vector&& other) noexcept {
+    if (this != &other) {
+      clear();
+      for (auto& e : other) {
+        emplace_back(std::move(e));
+      }
+      other.clear();
+    }
+    return *this;
+  }
+
+  ~inplace_vector() { clear(); }
+
+  /**
+   * Construct an element at the end, or return nullptr if the vector is full.
+   */
+  template <typename... Args> T* try_emplace_back(Args&&... args) {
+    if (size_ == N) {
+      return nullptr;
+    }
+    auto ret = std::construct_at(data() + size_, std::forward<Args>(args)...);
+    ++size_;
+    return ret;
+  }
+
+  T* try_push_back(const T& value) { return try_emplace_back(value); }
+
+  T* try_push_back(T&& value) { return try_emplace_back(std::move(value)); }
+
+  template <typename... Args> T& emplace_back(Args&&... args) {
+    ASSERT_WITH_BACKTRACE(size_ < N);
+    return *try_emplace_back(std::forward<Args>(args)...);
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  /**
+   * Insert value before pos, shifting the tail up by one. Returns nullptr if the vector is full.
+   */
+  T* try_insert(const_iterator pos, T value) {
+    const auto index = static_cast<size_type>(pos - begin());
+    if (try_emplace_back(std::move(value)) == nullptr) {
+      return nullptr;
+    }
+    for (auto i = size_ - 1U; i > index; --i) {
+      std::swap(data()[i], data()[i - 1U]);
+    }
+    return data() + index;
+  }
+
+  /**
+   * Remove the element at pos, shifting the tail down by one.
+   */
+  iterator erase(const_iterator pos) {
+    const auto index = static_cast<size_type>(pos - begin());
+    for (auto i = index; i + 1U < size_; ++i) {
+      data()[i] = std::move(data()[i + 1U]);
+    }
+    pop_back();
+    return begin() + index;
+  }
+
+  void pop_back() {
+    ASSERT_WITH_BACKTRACE(size_ != 0U);
+    --size_;
+    std::destroy_at(data() + size_);
+  }
+
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    size_ = 0U;
+  }
+
+  size_type size() const noexcept { return size_; }
+
+  static constexpr size_type capacity() noexcept { return N; }
+
+  bool empty() const noexcept { return size_ == 0U; }
+
+  bool full() const noexcept { return size_ == N; }
+
+  T* data() noexcept { return std::launder(reinterpret_cast<T*>(storage_)); }
+
+  const T* data() const noexcept { return std::launder(reinterpret_cast<const T*>(storage_)); }
+
+  T& operator[](size_type i) noexcept { return data()[i]; }
+
+  const T& operator[](size_type i) const noexcept { return data()[i]; }
+
+  T& front() noexcept { return data()[0]; }
+
+  T& back() noexcept { return data()[size_ - 1U]; }
+
+  iterator begin() noexcept { return data(); }
+
+  iterator end() noexcept { return data() + size_; }
+
+  const_iterator begin() const noexcept { return data(); }
+
+  const_iterator end() const noexcept { return data() + size_; }
+
+  operator std::span<T>() noexcept { return {data(), size_}; }
+
+  operator std::span<const T>() const noexcept { return {data(), size_}; }
+
+private:
+  alignas(T) unsigned char storage_[sizeof(T) * N];
+  size_type size_;
+}; // class inplace_vector
+
+} // namespace container
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_CONTAINER_INPLACE_VECTOR_HXX
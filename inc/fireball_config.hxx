@@ -8,4 +8,177 @@
 
 #define FIREBALL_HOST_HEAP_SIZE (1024U * 1U)
 
+/**
+ * Heap partitions, laid out in this order in one static RAM block (see allocator/partition.hxx).
+ * Every size must be a multiple of FIREBALL_PARTITION_GRANULE.
+ */
+#define FIREBALL_COOS_KERNEL_HEAP_SIZE (1024U * 4U)
+#define FIREBALL_WASM_RUNTIME_HEAP_SIZE (1024U * 8U)
+#define FIREBALL_SUBSYSTEM_HEAP_SIZE (1024U * 4U)
+#define FIREBALL_SERVICE_HEAP_SIZE (1024U * 4U)
+#define FIREBALL_GUEST_HEAP_SIZE (1024U * 24U)
+#define FIREBALL_CORO_STACK_AREA_SIZE (1024U * 8U)
+
+/**
+ * Interpreter frame stack of one coroutine, carved from the coroutine stack area.
+ */
+#define FIREBALL_FRAME_STACK_SIZE (1024U * 1U)
+
+/**
+ * Backend of the dynamic partitions: 0 selects dlmalloc (specified_allocator), 1 selects TLSF
+ * (tlsf_allocator). Set by the meson option tlsf_partitions.
+ */
+#ifndef FIREBALL_SUBSYSTEM_HEAP_TLSF
+#define FIREBALL_SUBSYSTEM_HEAP_TLSF (0)
+#endif
+#ifndef FIREBALL_SERVICE_HEAP_TLSF
+#define FIREBALL_SERVICE_HEAP_TLSF (0)
+#endif
+#ifndef FIREBALL_GUEST_HEAP_TLSF
+#define FIREBALL_GUEST_HEAP_TLSF (0)
+#endif
+
+/**
+ * Maximum number of reclaimers registered per allocator instance (allocator/reclaimer.hxx).
+ */
+#define FIREBALL_MAX_RECLAIMERS (4U)
+
+/**
+ * Relocatable, compactable part of the guest partition (allocator/handle_heap.hxx).
+ *   FIREBALL_GUEST_HANDLE_HEAP_SIZE - Bytes carved from the guest heap on first use.
+ *   FIREBALL_GUEST_HANDLE_COUNT     - Entries of its handle table.
+ */
+#define FIREBALL_GUEST_HANDLE_HEAP_SIZE (1024U * 8U)
+#define FIREBALL_GUEST_HANDLE_COUNT (128U)
+
+/**
+ * Unit of the address to partition lookup table (power of two).
+ */
+#define FIREBALL_PARTITION_GRANULE (1024U)
+
+/**
+ * RAM of the smallest target and the part of it kept for .data/.bss and the main stack.
+ */
+#define FIREBALL_TARGET_RAM_SIZE (1024U * 64U)
+#define FIREBALL_SYSTEM_RAM_RESERVE (1024U * 8U)
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define FIREBALL_CACHE_LINE_SIZE (64U)
+#else
+#define FIREBALL_CACHE_LINE_SIZE (32U)
+#endif
+
+/**
+ * Maximum number of COOS tasks, each with its own task heap.
+ */
+#define FIREBALL_MAX_TASKS (16U)
+
+/**
+ * Number of cores, each running its own hypervisor instance with per-core heaps. Set by the
+ * meson option core_count (two on the native target, one on MCU targets by default).
+ */
+#ifndef FIREBALL_CORE_COUNT
+#define FIREBALL_CORE_COUNT (1U)
+#endif
+
+/**
+ * Slab front-end of specified_allocator.
+ *
+ *   FIREBALL_SLAB_PAGE_SIZE - Size of a page refilled from the mspace (power of two).
+ *   FIREBALL_SLAB_GRANULE   - Size step between two size classes (power of two).
+ *   FIREBALL_SLAB_MAX_SIZE  - Largest request served by the slab, larger ones go to the mspace.
+ */
+#define FIREBALL_SLAB_PAGE_SIZE (256U)
+#define FIREBALL_SLAB_GRANULE (16U)
+#define FIREBALL_SLAB_MAX_SIZE (64U)
+
+/**
+ * Allocator statistics (live/peak bytes, counts, size histogram) per allocator instance.
+ * Set by the meson option alloc_stats; 0 compiles the statistics out.
+ */
+#ifndef FIREBALL_ALLOC_STATS
+#define FIREBALL_ALLOC_STATS (0)
+#endif
+
+/**
+ * Allocation trace recorder in the global operator new/delete (see allocator/alloc_trace.hxx).
+ * Set by the meson option alloc_trace; 0 compiles the recorder out.
+ *   FIREBALL_ALLOC_TRACE_CAPACITY - Records kept in the ring buffer (16 bytes each, power of 2).
+ */
+#ifndef FIREBALL_ALLOC_TRACE
+#define FIREBALL_ALLOC_TRACE (0)
+#endif
+#ifndef FIREBALL_ALLOC_TRACE_CAPACITY
+#define FIREBALL_ALLOC_TRACE_CAPACITY (1024U)
+#endif
+
+/**
+ * Sampling heap profiler in the global operator new (see allocator/heap_profiler.hxx).
+ * Set by the meson option heap_profile; 0 compiles the profiler out.
+ *   FIREBALL_HEAP_PROFILE_DEPTH - Return addresses kept per sample.
+ *   FIREBALL_HEAP_PROFILE_SLOTS - Call sites kept in the table (power of 2).
+ */
+#ifndef FIREBALL_HEAP_PROFILE
+#define FIREBALL_HEAP_PROFILE (0)
+#endif
+#ifndef FIREBALL_HEAP_PROFILE_DEPTH
+#define FIREBALL_HEAP_PROFILE_DEPTH (4U)
+#endif
+#ifndef FIREBALL_HEAP_PROFILE_SLOTS
+#define FIREBALL_HEAP_PROFILE_SLOTS (64U)
+#endif
+
+/**
+ * Sampling profiler of host and guest call stacks (see utils/sampling_profiler.hxx).
+ * Set by the meson option sample_profile; 0 compiles the profiler out.
+ *   FIREBALL_SAMPLE_PROFILE_DEPTH       - Host return addresses kept per sample.
+ *   FIREBALL_SAMPLE_PROFILE_GUEST_DEPTH - Guest functions kept per sample.
+ *   FIREBALL_SAMPLE_PROFILE_SLOTS       - Distinct stacks kept in the table (power of 2).
+ */
+#ifndef FIREBALL_SAMPLE_PROFILE
+#define FIREBALL_SAMPLE_PROFILE (0)
+#endif
+#ifndef FIREBALL_SAMPLE_PROFILE_DEPTH
+#define FIREBALL_SAMPLE_PROFILE_DEPTH (16U)
+#endif
+#ifndef FIREBALL_SAMPLE_PROFILE_GUEST_DEPTH
+#define FIREBALL_SAMPLE_PROFILE_GUEST_DEPTH (8U)
+#endif
+#ifndef FIREBALL_SAMPLE_PROFILE_SLOTS
+#define FIREBALL_SAMPLE_PROFILE_SLOTS (256U)
+#endif
+
+/**
+ * Arenas reserved with mmap(MAP_NORESERVE) and committed on first touch (see
+ * allocator/vm_arena.hxx). Set by meson for the native target; 0 on MCU targets.
+ *   FIREBALL_VM_RELEASE_THRESHOLD - Freed blocks of at least this size give their pages back.
+ */
+#ifndef FIREBALL_VM_ARENA
+#define FIREBALL_VM_ARENA (0)
+#endif
+#ifndef FIREBALL_VM_RELEASE_THRESHOLD
+#define FIREBALL_VM_RELEASE_THRESHOLD (1024U * 64U)
+#endif
+
+/**
+ * Backtraces, crash and OOM reports (see utils/backtrace.hxx).
+ *   FIREBALL_BACKTRACE_DEPTH     - Return addresses kept by a raw_backtrace.
+ *   FIREBALL_SYMBOL_CACHE_SLOTS  - Symbolized addresses kept by describe_backtrace().
+ *   FIREBALL_EMERGENCY_HEAP_SIZE - Heap kept for the symbolized crash report that follows the
+ *                                  raw one; 0 leaves symbolization to tools/symbolize_crash.sh.
+ */
+#ifndef FIREBALL_BACKTRACE_DEPTH
+#define FIREBALL_BACKTRACE_DEPTH (32U)
+#endif
+#ifndef FIREBALL_SYMBOL_CACHE_SLOTS
+#define FIREBALL_SYMBOL_CACHE_SLOTS (64U)
+#endif
+#ifndef FIREBALL_EMERGENCY_HEAP_SIZE
+#if FIREBALL_VM_ARENA
+#define FIREBALL_EMERGENCY_HEAP_SIZE (1024U * 1024U * 8U)
+#else
+#define FIREBALL_EMERGENCY_HEAP_SIZE (0U)
+#endif
+#endif
+
 #endif // #ifndef FIREBALL_CONFIG_HXX
@@ -6,24 +6,88 @@
 #ifndef FIREBALL_UTILS_BACKTRACE_HXX
 #define FIREBALL_UTILS_BACKTRACE_HXX
 
+#include <array>
 #include <commons.hxx>
+#include <cstddef>
 #include <stdexcept>
+#include <string>
 
 namespace fireball {
 namespace utils {
 
+/**
+ * raw_backtrace - Return addresses of a call stack, captured without symbolizing.
+ *
+ * Capturing costs one unwind into a fixed array and never allocates. Symbols are looked up only
+ * when the trace is described, through a cache shared by all traces, so frames seen before are
+ * not symbolized again. hash() identifies the stack, e.g. to count reports from the same site.
+ */
+class raw_backtrace {
+public:
+  static constexpr std::size_t DEPTH = FIREBALL_BACKTRACE_DEPTH;
+
+  raw_backtrace() noexcept : pcs_(), size_(0U) {}
+
+  /**
+   * Backtrace of the caller, innermost first, skipping its skip innermost frames.
+   */
+  [[gnu::noinline]] static raw_backtrace capture(std::size_t skip = 0U) noexcept;
+
+  std::size_t size() const noexcept { return size_; }
+
+  bool empty() const noexcept { return size_ == 0U; }
+
+  const uintptr_t* begin() const noexcept { return pcs_.data(); }
+
+  const uintptr_t* end() const noexcept { return pcs_.data() + size_; }
+
+  /**
+   * FNV-1a hash of the return addresses; never 0.
+   */
+  uint32_t hash() const noexcept;
+
+private:
+  std::array<uintptr_t, DEPTH> pcs_;
+  std::size_t size_;
+}; // class raw_backtrace
+
+/**
+ * Symbolized text of trace, one frame per line after a "trace 0x<hash>:" header. A stack that
+ * was described before is summarized by its hash and how often it has been seen, unless full is
+ * set (e.g., for a crash report, which must stand on its own).
+ */
+extern std::string describe_backtrace(const raw_backtrace& trace, bool full = false);
+
 /**
  * Exception with backtrace.
+ *
+ * The constructor only captures a raw_backtrace; what() symbolizes it on its first call.
  */
 class exception_with_backtrace : public std::runtime_error {
 public:
   exception_with_backtrace(const std::string& msg);
 
   virtual ~exception_with_backtrace() noexcept = default;
+
+  /**
+   * Message followed by the symbolized backtrace.
+   */
+  const char* what() const noexcept override;
+
+  const raw_backtrace& backtrace() const noexcept { return backtrace_; }
+
+private:
+  raw_backtrace backtrace_;
+  mutable std::string what_;
 };
 
 /**
  * Report backtrace and terminate (for exception-disabled environments).
+ *
+ * The report is written in two steps. First msg and the raw return addresses, without
+ * allocating, so that it also works when a heap is exhausted. Then the same trace symbolized by
+ * describe_backtrace(), on an emergency heap of FIREBALL_EMERGENCY_HEAP_SIZE bytes. If that heap
+ * is 0, tools/symbolize_crash.sh symbolizes the raw addresses offline.
  */
 extern void report_backtrace_and_terminate(const char* msg) noexcept;
 
@@ -39,10 +103,10 @@ extern void report_backtrace_and_terminate(const char* msg) noexcept;
 /**
  * Throw nested exception with backtrace.
  */
-#define THROW_NESTED_BACKTRACE(meg, outer)                                                         \
+#define THROW_NESTED_BACKTRACE(msg, outer)                                                         \
   do {                                                                                             \
     try {                                                                                          \
-      throw fireball::utils::exception_with_backtrace(message);                                    \
+      throw fireball::utils::exception_with_backtrace(msg);                                        \
     } catch (...) {                                                                                \
       std::throw_with_nested(outer());                                                             \
     }                                                                                              \
@@ -0,0 +1,61 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_UTILS_CYCLE_COUNTER_HXX
+#define FIREBALL_UTILS_CYCLE_COUNTER_HXX
+
+#include <chrono>
+#include <commons.hxx>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace fireball {
+namespace utils {
+
+/**
+ * Free-running cycle counter of the target.
+ *
+ *   x86        - TSC
+ *   AArch64    - virtual counter (CNTVCT_EL0)
+ *   Cortex-M33 - DWT CYCCNT (enable_cycle_counter() must be called once)
+ *   RISC-V     - cycle CSR
+ *   otherwise  - steady_clock in nanoseconds
+ */
+inline uint64_t cycle_counter() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ret;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(ret));
+  return ret;
+#elif defined(__ARM_ARCH_8M_MAIN__)
+  return *reinterpret_cast<volatile uint32_t*>(0xE0001004U);
+#elif defined(__riscv)
+  uint32_t ret;
+  asm volatile("rdcycle %0" : "=r"(ret));
+  return ret;
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+#endif
+}
+
+/**
+ * Start the cycle counter where it is off after reset (DWT CYCCNT on Cortex-M33).
+ */
+inline void enable_cycle_counter() noexcept {
+#if defined(__ARM_ARCH_8M_MAIN__)
+  *reinterpret_cast<volatile uint32_t*>(0xE000EDFCU) |= 1U << 24U; // DEMCR.TRCENA
+  *reinterpret_cast<volatile uint32_t*>(0xE0001004U) = 0U;         // DWT_CYCCNT
+  *reinterpret_cast<volatile uint32_t*>(0xE0001000U) |= 1U;        // DWT_CTRL.CYCCNTENA
+#endif
+}
+
+} // namespace utils
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_UTILS_CYCLE_COUNTER_HXX
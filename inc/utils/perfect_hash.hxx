@@ -0,0 +1,205 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_UTILS_PERFECT_HASH_HXX
+#define FIREBALL_UTILS_PERFECT_HASH_HXX
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <commons.hxx>
+#include <concepts>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace fireball {
+namespace utils {
+
+/**
+ * Finalizer of MurmurHash3: every input bit affects every output bit.
+ */
+constexpr uint32_t hash_mix32(uint32_t x) noexcept {
+  x ^= x >> 16U;
+  x *= 0x85EBCA6BU;
+  x ^= x >> 13U;
+  x *= 0xC2B2AE35U;
+  x ^= x >> 16U;
+  return x;
+}
+
+/**
+ * perfect_hash_key - Hash of a key type usable with perfect_hash_map.
+ *
+ * Specialized for integers, enums and std::string_view; specialize it for other key types.
+ */
+template <typename Key> struct perfect_hash_key;
+
+template <typename Key>
+  requires std::integral<Key> || std::is_enum_v<Key>
+struct perfect_hash_key<Key> {
+  static constexpr uint32_t hash(Key key) noexcept {
+    const auto x = static_cast<uint64_t>(key);
+    return hash_mix32(static_cast<uint32_t>(x) ^ static_cast<uint32_t>(x >> 32U));
+  }
+};
+
+template <> struct perfect_hash_key<std::string_view> {
+  // FNV-1a.
+  static constexpr uint32_t hash(std::string_view key) noexcept {
+    uint32_t ret = 2166136261U;
+    for (auto c : key) {
+      ret = (ret ^ static_cast<uint8_t>(c)) * 16777619U;
+    }
+    return ret;
+  }
+};
+
+/**
+ * perfect_hash_map - Collision-free lookup table built at compile time from a fixed key set.
+ *
+ * The builder follows CHD (compress, hash, displace): keys are grouped into buckets by their
+ * hash, and for each bucket, largest first, it searches a displacement that sends every key of
+ * the bucket to a free slot. A lookup then hashes the key once, reads the displacement of its
+ * bucket and compares the key in the single slot it points to: one probe and one comparison
+ * instead of log2(n) hard-to-predict comparisons of a binary search.
+ *
+ * Declared constexpr, the whole table is computed by the compiler and placed in ROM. valid()
+ * is false if two keys have the same hash, duplicates included, or no displacement was found;
+ * check it with a static_assert.
+ *
+ *   inline constexpr auto routes = utils::make_perfect_hash<std::string_view, uint16_t>({
+ *       {"/log", 0U}, {"/ipc", 1U}, ...});
+ *   static_assert(routes.valid());
+ *
+ * Template Parameters:
+ *   Key   - Key type with a perfect_hash_key specialization
+ *   Value - Mapped type
+ *   N     - Number of keys (compile-time constant)
+ */
+template <typename Key, typename Value, std::size_t N> class perfect_hash_map {
+public:
+  using entry = std::pair<Key, Value>;
+
+  static constexpr std::size_t SLOTS = std::bit_ceil(N + N / 4U + 1U);
+  static constexpr std::size_t BUCKETS = N / 2U + 1U;
+  static constexpr uint32_t MAX_DISPLACEMENT = 1U << 16U;
+
+  constexpr explicit perfect_hash_map(const std::array<entry, N>& entries) noexcept
+      : displacements_(), slots_(), used_(), valid_(true) {
+    // sort the keys by bucket: bucket b owns members[starts[b]] .. members[starts[b + 1] - 1].
+    std::array<uint32_t, N> hashes = {};
+    std::array<std::size_t, BUCKETS + 1U> starts = {};
+    for (std::size_t i = 0U; i < N; ++i) {
+      hashes[i] = perfect_hash_key<Key>::hash(entries[i].first);
+      ++starts[bucket_of(hashes[i]) + 1U];
+    }
+    std::size_t largest = 0U;
+    for (std::size_t b = 0U; b < BUCKETS; ++b) {
+      largest = std::max(largest, starts[b + 1U]);
+      starts[b + 1U] += starts[b];
+    }
+    std::array<std::size_t, N> members = {};
+    std::array<std::size_t, BUCKETS> fill = {};
+    for (std::size_t i = 0U; i < N; ++i) {
+      const auto b = bucket_of(hashes[i]);
+      members[starts[b] + fill[b]++] = i;
+    }
+    // place larger buckets first, while most slots are still free.
+    for (auto size = largest; size > 0U && valid_; --size) {
+      for (std::size_t b = 0U; b < BUCKETS && valid_; ++b) {
+        if (starts[b + 1U] - starts[b] == size) {
+          valid_ = place(b, entries, hashes, &members[starts[b]], size);
+        }
+      }
+    }
+  }
+
+  /**
+   * Value of key, or nullptr if key is not in the table.
+   */
+  constexpr const Value* find(const Key& key) const noexcept {
+    const auto hash = perfect_hash_key<Key>::hash(key);
+    const auto slot = slot_of(hash, displacements_[bucket_of(hash)]);
+    return used_[slot] && slots_[slot].first == key ? &slots_[slot].second : nullptr;
+  }
+
+  constexpr bool contains(const Key& key) const noexcept { return find(key) != nullptr; }
+
+  constexpr bool valid() const noexcept { return valid_; }
+
+  static constexpr std::size_t size() noexcept { return N; }
+
+private:
+  static constexpr std::size_t bucket_of(uint32_t hash) noexcept {
+    return static_cast<std::size_t>((static_cast<uint64_t>(hash) * BUCKETS) >> 32U);
+  }
+
+  static constexpr std::size_t slot_of(uint32_t hash, uint32_t displacement) noexcept {
+    return hash_mix32(hash ^ displacement) & (SLOTS - 1U);
+  }
+
+  /**
+   * Find a displacement sending the count keys of bucket b, listed by members, to distinct free
+   * slots and fill them.
+   */
+  constexpr bool place(std::size_t b, const std::array<entry, N>& entries,
+                       const std::array<uint32_t, N>& hashes, const std::size_t* members,
+                       std::size_t count) noexcept {
+    // keys with the same hash, duplicates included, share a slot whatever the displacement.
+    for (std::size_t i = 0U; i < count; ++i) {
+      for (std::size_t j = 0U; j < i; ++j) {
+        if (hashes[members[i]] == hashes[members[j]]) {
+          return false;
+        }
+      }
+    }
+    std::array<std::size_t, N> slots = {};
+    for (uint32_t d = 0U; d < MAX_DISPLACEMENT; ++d) {
+      bool fits = true;
+      for (std::size_t i = 0U; i < count && fits; ++i) {
+        slots[i] = slot_of(hashes[members[i]], d);
+        fits = !used_[slots[i]];
+        for (std::size_t j = 0U; j < i && fits; ++j) {
+          fits = slots[j] != slots[i];
+        }
+      }
+      if (!fits) {
+        continue;
+      }
+      for (std::size_t i = 0U; i < count; ++i) {
+        slots_[slots[i]] = entries[members[i]];
+        used_[slots[i]] = true;
+      }
+      displacements_[b] = d;
+      return true;
+    }
+    return false;
+  }
+
+  std::array<uint32_t, BUCKETS> displacements_;
+  std::array<entry, SLOTS> slots_;
+  std::array<bool, SLOTS> used_;
+  bool valid_;
+}; // class perfect_hash_map
+
+/**
+ * Build a perfect_hash_map from a braced list of {key, value} pairs.
+ */
+template <typename Key, typename Value, std::size_t N>
+constexpr perfect_hash_map<Key, Value, N>
+make_perfect_hash(const std::pair<Key, Value> (&entries)[N]) noexcept {
+  std::array<std::pair<Key, Value>, N> list = {};
+  for (std::size_t i = 0U; i < N; ++i) {
+    list[i] = entries[i];
+  }
+  return perfect_hash_map<Key, Value, N>(list);
+}
+
+} // namespace utils
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_UTILS_PERFECT_HASH_HXX
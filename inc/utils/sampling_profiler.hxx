@@ -0,0 +1,100 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_UTILS_SAMPLING_PROFILER_HXX
+#define FIREBALL_UTILS_SAMPLING_PROFILER_HXX
+
+#include <commons.hxx>
+#include <cstddef>
+
+namespace fireball {
+namespace utils {
+
+/**
+ * Sink of sample_profile_dump(); called with consecutive chunks of the text dump.
+ */
+using sample_writer = void (*)(const void* data, std::size_t size, void* arg);
+
+/**
+ * Source of the guest call stack: writes up to max function indices of the running wasm
+ * instance into out, innermost first, and returns how many it wrote. It runs inside the timer
+ * interrupt or signal handler, so it may only read the interpreter's frame array.
+ */
+using guest_stack_provider = std::size_t (*)(uint32_t* out, std::size_t max, void* arg);
+
+/**
+ * Record one sample of the code interrupted at pc with frame pointer fp and stack pointer sp,
+ * on a stack whose top (highest address, exclusive) is stack_top.
+ *
+ * The host stack is walked from fp, the guest stack is read from the registered provider, and
+ * the folded stack is counted in a fixed table, so the sample neither allocates nor locks. On
+ * Linux the SIGPROF handler calls it; on the MCU the periodic timer interrupt calls it with the
+ * pc, frame register and stack pointer of the exception frame and the top of the interrupted
+ * task's stack. Does nothing while the profiler is stopped or without FIREBALL_SAMPLE_PROFILE
+ * (meson option sample_profile).
+ *
+ * The interrupted code may use the frame register for anything, so fp is only followed if it is
+ * aligned and lies in [sp, stack_top), and so is every frame after it; with stack_top nullptr
+ * only pc is recorded. A leaf function that the compiler left without a frame record hides its
+ * caller, as with any frame pointer unwinder.
+ */
+void sample_profile_tick(uintptr_t pc, const void* fp, const void* sp,
+                         const void* stack_top) noexcept;
+
+/**
+ * Record the stack bounds of the calling thread for the SIGPROF handler (Linux only). Threads
+ * that never call it are sampled without their host frames; sample_profile_start() calls it for
+ * its own thread. Returns false if the bounds are unknown or outside Linux.
+ */
+bool sample_profile_attach_thread() noexcept;
+
+/**
+ * Start sampling. On Linux this arms ITIMER_PROF at hz samples per second of CPU time; on the
+ * MCU hz is ignored and the rate is that of the timer calling sample_profile_tick(). Returns
+ * false if the profiler is compiled out or the timer cannot be set.
+ */
+bool sample_profile_start(uint32_t hz) noexcept;
+
+/**
+ * Stop sampling; the collected stacks are kept for sample_profile_dump().
+ */
+void sample_profile_stop() noexcept;
+
+/**
+ * Drop every stack collected so far. The profiler must be stopped first: a tick running
+ * meanwhile would write the table being cleared.
+ */
+void sample_profile_clear() noexcept;
+
+/**
+ * Set the provider of the guest call stack (nullptr to sample host frames only).
+ */
+void sample_profile_set_guest_stack(guest_stack_provider provider, void* arg) noexcept;
+
+/**
+ * Write the table in the folded format of flamegraph.pl without allocating, one line per
+ * distinct stack, outermost frame first:
+ *
+ *   wasm:<function index>;...;0x<host address>;... <samples>
+ *
+ * Guest frames come first, so the time spent in the interpreter and the runtime API is charged
+ * to the wasm function that caused it. Host addresses are relative to the image base and point
+ * at the call instruction (or the interrupted instruction for the innermost frame);
+ * tools/symbolize_folded.sh replaces them with function names. Samples lost because the table
+ * was full are reported as the stack "[dropped]". The profiler must be stopped first (debug
+ * builds check it): ticks neither lock nor block, so one running during the dump would change
+ * the entry being formatted.
+ */
+void sample_profile_dump(sample_writer writer, void* arg) noexcept;
+
+/**
+ * Dump the profile to a POSIX file descriptor (host builds only).
+ */
+void sample_profile_dump_fd(int fd) noexcept;
+
+} // namespace utils
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_UTILS_SAMPLING_PROFILER_HXX
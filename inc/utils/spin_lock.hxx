@@ -0,0 +1,52 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_UTILS_SPIN_LOCK_HXX
+#define FIREBALL_UTILS_SPIN_LOCK_HXX
+
+#include <atomic>
+#include <commons.hxx>
+
+namespace fireball {
+namespace utils {
+
+/**
+ * spin_lock - Busy-waiting lock for short critical sections shared by the cores.
+ *
+ * There is no scheduler to sleep on below the allocators, so waiting cores spin. Hold it only
+ * around a few table or heap operations, and never across a call that can take it again.
+ */
+class spin_lock {
+public:
+  void lock() noexcept {
+    while (flag_.test_and_set(std::memory_order_acquire)) {
+      // retry.
+    }
+  }
+
+  void unlock() noexcept { flag_.clear(std::memory_order_release); }
+
+  /**
+   * Holds the lock for the lifetime of the scope.
+   */
+  class guard {
+  public:
+    explicit guard(spin_lock& lock) noexcept : lock_(lock) { lock_.lock(); }
+    ~guard() noexcept { lock_.unlock(); }
+    guard(const guard&) = delete;
+    guard& operator=(const guard&) = delete;
+
+  private:
+    spin_lock& lock_;
+  };
+
+private:
+  std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+}; // class spin_lock
+
+} // namespace utils
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_UTILS_SPIN_LOCK_HXX
@@ -0,0 +1,154 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_UTILS_STACK_WALK_HXX
+#define FIREBALL_UTILS_STACK_WALK_HXX
+
+#include <commons.hxx>
+#include <cstddef>
+#include <cstdint>
+#if defined(__linux__)
+#include <link.h>
+#endif
+#if defined(__linux__) && __has_include(<unwind.h>)
+#include <unwind.h>
+#endif
+
+namespace fireball {
+namespace utils {
+
+/**
+ * Largest distance between two frames the walker follows; anything further is garbage.
+ */
+inline constexpr uintptr_t MAX_FRAME_SIZE = 64U * 1024U;
+
+/**
+ * Collect up to max return addresses from the frame pointer chain starting at frame fp,
+ * innermost first, skipping the first skip of them. fp itself must be a valid frame.
+ *
+ * It stops at the first frame pointer that is null, misaligned, does not move up the stack by
+ * at most MAX_FRAME_SIZE, or whose frame record does not end below limit (the top of the
+ * stack, if known), so a frame built without a frame pointer ends the walk instead of sending
+ * it off the stack. On targets without a known frame record layout it returns nothing.
+ */
+inline std::size_t walk_frame_pointers([[maybe_unused]] const void* fp,
+                                       [[maybe_unused]] uintptr_t* out,
+                                       [[maybe_unused]] std::size_t max,
+                                       [[maybe_unused]] std::size_t skip = 0U,
+                                       [[maybe_unused]] uintptr_t limit = UINTPTR_MAX) noexcept {
+  std::size_t count = 0U;
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(__riscv)
+  // x86 and AArch64: fp[0] = caller's fp, fp[1] = return address.
+  // RISC-V: fp[-2] = caller's fp, fp[-1] = return address.
+#if defined(__riscv)
+  constexpr std::ptrdiff_t LINK = -2;
+#else
+  constexpr std::ptrdiff_t LINK = 0;
+#endif
+  auto frame = static_cast<const uintptr_t*>(fp);
+  while (frame != nullptr && count < max) {
+    const auto pc = frame[LINK + 1];
+    const auto next = reinterpret_cast<const uintptr_t*>(frame[LINK]);
+    if (pc == 0U) {
+      break;
+    }
+    if (skip != 0U) {
+      --skip;
+    } else {
+      out[count++] = pc;
+    }
+    if (next <= frame ||
+        reinterpret_cast<uintptr_t>(next) - reinterpret_cast<uintptr_t>(frame) > MAX_FRAME_SIZE ||
+        (reinterpret_cast<uintptr_t>(next) & (sizeof(uintptr_t) - 1U)) != 0U ||
+        reinterpret_cast<uintptr_t>(next + LINK + 2) > limit) {
+      break;
+    }
+    frame = next;
+  }
+#endif
+  return count;
+}
+
+/**
+ * Collect up to max return addresses by following the frame pointer chain, innermost first,
+ * starting with the one into the calling function and skipping the first skip of them.
+ *
+ * Unlike std::stacktrace it neither allocates nor symbolizes, so it is usable inside operator
+ * new and signal handlers. It needs frames built with -fno-omit-frame-pointer. On targets
+ * without a usable frame record layout only the immediate caller is returned.
+ */
+[[gnu::noinline]] inline std::size_t capture_return_addresses(uintptr_t* out, std::size_t max,
+                                                              std::size_t skip = 0U) noexcept {
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(__riscv)
+  return walk_frame_pointers(__builtin_frame_address(0), out, max, skip);
+#else
+  if (skip == 0U && max != 0U) {
+    out[0] = reinterpret_cast<uintptr_t>(__builtin_return_address(0));
+    return 1U;
+  }
+  return 0U;
+#endif
+}
+
+/**
+ * Collect return addresses like capture_return_addresses(), but through the unwinder and the
+ * .eh_frame tables where the host has them, so frames built without a frame pointer are not
+ * lost. Does not allocate. Elsewhere it falls back to the frame pointer walk.
+ */
+[[gnu::noinline]] inline std::size_t unwind_return_addresses(uintptr_t* out, std::size_t max,
+                                                             std::size_t skip = 0U) noexcept {
+#if defined(__linux__) && __has_include(<unwind.h>)
+  struct walk_state {
+    uintptr_t* out;
+    std::size_t max;
+    std::size_t skip;
+    std::size_t count;
+  };
+  // the first frame reported is this function.
+  walk_state state = {out, max, skip + 1U, 0U};
+  if (max != 0U) {
+    _Unwind_Backtrace(
+        [](_Unwind_Context* context, void* arg) {
+          auto s = static_cast<walk_state*>(arg);
+          const auto pc = static_cast<uintptr_t>(_Unwind_GetIP(context));
+          if (pc == 0U) {
+            return _URC_END_OF_STACK;
+          }
+          if (s->skip != 0U) {
+            --s->skip;
+          } else {
+            s->out[s->count++] = pc;
+          }
+          return s->count < s->max ? _URC_NO_REASON : _URC_END_OF_STACK;
+        },
+        &state);
+  }
+  return state.count;
+#else
+  return capture_return_addresses(out, max, skip + 1U);
+#endif
+}
+
+/**
+ * Load address of the main executable, to be subtracted from return addresses of a PIE host
+ * binary before they are symbolized offline; 0 elsewhere. Does not allocate.
+ */
+inline uintptr_t image_base() noexcept {
+  uintptr_t ret = 0U;
+#if defined(__linux__)
+  dl_iterate_phdr(
+      [](dl_phdr_info* info, std::size_t, void* data) {
+        *static_cast<uintptr_t*>(data) = info->dlpi_addr;
+        return 1;
+      },
+      &ret);
+#endif
+  return ret;
+}
+
+} // namespace utils
+} // namespace fireball
+
+#endif // #ifndef FIREBALL_UTILS_STACK_WALK_HXX
@@ -0,0 +1,122 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * alloc_trace.cxx - Allocation trace ring buffer.
+ *
+ * Records live in a preallocated ring of FIREBALL_ALLOC_TRACE_CAPACITY entries; when it is
+ * full the oldest records are overwritten and counted as dropped. Slots are claimed with one
+ * atomic increment, so the recorder never locks or allocates and is safe to call from the
+ * operator new/delete overrides. With FIREBALL_ALLOC_TRACE disabled the ring is not built and
+ * dumps are empty.
+ *
+ * The dump format (trace_header + trace_records) is read by bench/alloc_replay.cxx.
+ */
+#include <allocator/alloc_trace.hxx>
+#include <array>
+#include <atomic>
+#include <utils/cycle_counter.hxx>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace fireball {
+namespace allocator {
+
+namespace detail {
+bool alloc_trace_enabled = false;
+} // namespace detail
+
+namespace {
+
+#if FIREBALL_ALLOC_TRACE
+constexpr uint32_t CAPACITY = FIREBALL_ALLOC_TRACE_CAPACITY;
+
+static_assert((CAPACITY & (CAPACITY - 1U)) == 0U, "trace capacity must be a power of two");
+
+std::array<trace_record, CAPACITY> records;
+#else
+constexpr uint32_t CAPACITY = 0U;
+#endif
+
+// total number of records claimed since the last clear.
+std::atomic<uint32_t> head = 0U;
+
+} // namespace
+
+namespace detail {
+
+void alloc_trace_record([[maybe_unused]] trace_op op, [[maybe_unused]] std::size_t size,
+                        [[maybe_unused]] std::size_t alignment,
+                        [[maybe_unused]] const void* ptr) noexcept {
+#if FIREBALL_ALLOC_TRACE
+  const auto index = head.fetch_add(1U, std::memory_order_relaxed) & (CAPACITY - 1U);
+  records[index] = trace_record{
+      static_cast<uint32_t>(utils::cycle_counter()),
+      static_cast<uint32_t>(size),
+      static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ptr)),
+      op,
+      static_cast<uint8_t>(std::countr_zero(alignment == 0U ? 1U : alignment)),
+      partition_of(ptr),
+      0U,
+  };
+#endif
+}
+
+} // namespace detail
+
+void alloc_trace_enable(bool enable) noexcept { detail::alloc_trace_enabled = enable; }
+
+void alloc_trace_clear() noexcept { head.store(0U, std::memory_order_relaxed); }
+
+std::size_t alloc_trace_dump(trace_writer writer, void* arg) noexcept {
+  const auto enabled = detail::alloc_trace_enabled;
+  detail::alloc_trace_enabled = false;
+
+  const auto total = head.load(std::memory_order_relaxed);
+  const auto count = total < CAPACITY ? total : CAPACITY;
+  const trace_header header = {trace_header::MAGIC, trace_header::VERSION,
+                               static_cast<uint16_t>(sizeof(trace_record)), count,
+                               total - count};
+  writer(&header, sizeof(header), arg);
+#if FIREBALL_ALLOC_TRACE
+  // the oldest record sits right after the newest once the ring has wrapped.
+  const auto first = total & (CAPACITY - 1U);
+  if (count == CAPACITY && first != 0U) {
+    writer(&records[first], (CAPACITY - first) * sizeof(trace_record), arg);
+    writer(&records[0], first * sizeof(trace_record), arg);
+  } else if (count != 0U) {
+    writer(&records[0], count * sizeof(trace_record), arg);
+  }
+#endif
+
+  detail::alloc_trace_enabled = enabled;
+  return count;
+}
+
+std::size_t alloc_trace_dump_fd([[maybe_unused]] int fd) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+  return alloc_trace_dump(
+      [](const void* data, std::size_t size, void* arg) {
+        const auto fd = *static_cast<int*>(arg);
+        auto p = static_cast<const uint8_t*>(data);
+        while (size != 0U) {
+          const auto n = ::write(fd, p, size);
+          if (n <= 0) {
+            return;
+          }
+          p += n;
+          size -= static_cast<std::size_t>(n);
+        }
+      },
+      &fd);
+#else
+  return 0U;
+#endif
+}
+
+} // namespace allocator
+} // namespace fireball
@@ -0,0 +1,103 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * frag_report.cxx - Heap fragmentation analysis on top of mspace_inspect_all.
+ *
+ * dlmalloc reports every chunk of the mspace with its payload range and used bytes (0 for a
+ * free chunk), including the top chunk, which is free memory at the end of the arena. The
+ * visitor folds them into a frag_report without allocating, so it also works from an
+ * allocation failure path.
+ */
+#include <algorithm>
+#include <allocator/frag_report.hxx>
+#include <bit>
+#include <cstdio>
+
+extern "C" {
+extern void mspace_inspect_all(void* msp, void (*handler)(void*, void*, std::size_t, void*),
+                               void* arg);
+} // extern "C" {
+
+namespace fireball {
+namespace allocator {
+
+namespace {
+
+struct inspect_context {
+  frag_report* report;
+  uintptr_t begin;
+  std::size_t cell_size;
+};
+
+std::size_t bin_of(std::size_t bytes) noexcept {
+  const auto bin = static_cast<std::size_t>(std::bit_width((bytes - (bytes != 0U)) >> 4U));
+  return std::min(bin, frag_report::HISTOGRAM_BINS - 1U);
+}
+
+void visit_chunk(void* start, void* end, std::size_t used, void* arg) noexcept {
+  auto& ctx = *static_cast<inspect_context*>(arg);
+  auto& report = *ctx.report;
+  const auto size = static_cast<std::size_t>(static_cast<uint8_t*>(end) -
+                                             static_cast<uint8_t*>(start));
+  uint8_t mark;
+  if (used != 0U) {
+    report.used_bytes += used;
+    ++report.used_chunks;
+    mark = frag_report::MAP_USED;
+  } else {
+    report.free_bytes += size;
+    ++report.free_chunks;
+    report.largest_free = std::max(report.largest_free, size);
+    ++report.histogram[bin_of(size)];
+    mark = frag_report::MAP_FREE;
+  }
+  const auto first = (reinterpret_cast<uintptr_t>(start) - ctx.begin) / ctx.cell_size;
+  const auto last = (reinterpret_cast<uintptr_t>(end) - 1U - ctx.begin) / ctx.cell_size;
+  for (auto cell = first; cell <= last && cell < frag_report::MAP_CELLS; ++cell) {
+    report.map[cell] |= mark;
+  }
+}
+
+} // namespace
+
+frag_report inspect_fragmentation(void* msp, const uint8_t* begin, const uint8_t* end) noexcept {
+  frag_report ret = {};
+  if (msp != nullptr) {
+    const auto size = static_cast<std::size_t>(end - begin);
+    inspect_context ctx = {&ret, reinterpret_cast<uintptr_t>(begin),
+                           std::max<std::size_t>(1U, (size + frag_report::MAP_CELLS - 1U) /
+                                                         frag_report::MAP_CELLS)};
+    mspace_inspect_all(msp, visit_chunk, &ctx);
+  }
+  return ret;
+}
+
+void print_frag_report(const char* name, const frag_report& report) noexcept {
+  std::fprintf(stderr,
+               "heap %s: used %zu bytes in %zu chunks, free %zu bytes in %zu chunks, "
+               "largest free %zu bytes, fragmentation %u.%u%%\n",
+               name, report.used_bytes, report.used_chunks, report.free_bytes, report.free_chunks,
+               report.largest_free, report.fragmentation_permille() / 10U,
+               report.fragmentation_permille() % 10U);
+  std::fprintf(stderr, "  free chunks:");
+  for (std::size_t i = 0U; i < frag_report::HISTOGRAM_BINS; ++i) {
+    if (report.histogram[i] != 0U) {
+      std::fprintf(stderr, " <=%zu:%zu", std::size_t(16U) << i, report.histogram[i]);
+    }
+  }
+  // ' ' no chunk (mspace header), '#' used, '.' free, '+' both.
+  constexpr char glyphs[] = {' ', '#', '.', '+'};
+  char map[frag_report::MAP_CELLS + 1U];
+  for (std::size_t i = 0U; i < frag_report::MAP_CELLS; ++i) {
+    map[i] = glyphs[report.map[i] & 3U];
+  }
+  map[frag_report::MAP_CELLS] = '\0';
+  std::fprintf(stderr, "\n  map: [%s]\n", map);
+}
+
+} // namespace allocator
+} // namespace fireball
@@ -0,0 +1,169 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * heap_profiler.cxx - Sampling heap profiler of the global operator new.
+ *
+ * A sample is taken whenever the byte countdown drops below zero. It captures a few return
+ * addresses with the frame pointer walker and adds the bytes it stands for to the entry of its
+ * call stack in a fixed open-addressing table, so neither sampling nor dumping allocates.
+ * An allocation larger than the interval may cross several intervals and counts for each.
+ *
+ * Every sample re-arms the countdown with an interval drawn uniformly from [T/2, 3T/2), which
+ * keeps the estimate of a call site (samples x T) unbiased without the cost of an exponential
+ * distribution.
+ */
+#include <algorithm>
+#include <allocator/heap_profiler.hxx>
+#include <array>
+#include <cstdio>
+#include <limits>
+#include <utils/stack_walk.hxx>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace fireball {
+namespace allocator {
+
+namespace detail {
+std::ptrdiff_t heap_profile_countdown = std::numeric_limits<std::ptrdiff_t>::max();
+} // namespace detail
+
+namespace {
+
+constexpr std::size_t DEPTH = FIREBALL_HEAP_PROFILE_DEPTH;
+constexpr std::size_t SLOTS = FIREBALL_HEAP_PROFILE_SLOTS;
+
+static_assert((SLOTS & (SLOTS - 1U)) == 0U, "heap profile slots must be a power of two");
+
+struct call_site {
+  uint32_t hash;
+  uint32_t samples;
+  std::size_t bytes;
+  std::array<uintptr_t, DEPTH> pcs;
+};
+
+std::array<call_site, SLOTS> sites;
+std::size_t interval = 1U;
+std::size_t dropped = 0U;
+uint32_t rng = 0x9E3779B9U;
+
+std::ptrdiff_t next_interval() noexcept {
+  rng ^= rng << 13U;
+  rng ^= rng >> 17U;
+  rng ^= rng << 5U;
+  return static_cast<std::ptrdiff_t>(interval / 2U + rng % interval);
+}
+
+uint32_t hash_of(const uintptr_t* pcs, std::size_t depth) noexcept {
+  uint32_t ret = 2166136261U;
+  for (std::size_t i = 0U; i < depth; ++i) {
+    ret = (ret ^ static_cast<uint32_t>(pcs[i] ^ (pcs[i] >> 16U >> 16U))) * 16777619U;
+  }
+  // 0 marks an empty slot.
+  return ret == 0U ? 1U : ret;
+}
+
+} // namespace
+
+namespace detail {
+
+void heap_profile_record([[maybe_unused]] std::size_t bytes) noexcept {
+  std::size_t crossed = 0U;
+  while (heap_profile_countdown < 0) {
+    heap_profile_countdown += next_interval();
+    ++crossed;
+  }
+
+  // skip the returns into this function and into operator new, which calls it directly: both
+  // heap_profile_sample() and this function are kept from being inlined the other way.
+  std::array<uintptr_t, DEPTH> pcs = {};
+  const auto depth = utils::capture_return_addresses(pcs.data(), DEPTH, 2U);
+  const auto hash = hash_of(pcs.data(), depth);
+  for (std::size_t i = 0U; i < SLOTS; ++i) {
+    auto& site = sites[(hash + i) & (SLOTS - 1U)];
+    if (site.hash == 0U) {
+      site.hash = hash;
+      site.pcs = pcs;
+    } else if (site.hash != hash || site.pcs != pcs) {
+      continue;
+    }
+    site.samples += static_cast<uint32_t>(crossed);
+    site.bytes += crossed * interval;
+    return;
+  }
+  dropped += crossed;
+}
+
+} // namespace detail
+
+void heap_profile_start(std::size_t bytes) noexcept {
+  // below 2 bytes the next interval could be 0 and heap_profile_record() would never return.
+  interval = std::max<std::size_t>(bytes, 2U);
+  detail::heap_profile_countdown = next_interval();
+}
+
+void heap_profile_stop() noexcept {
+  detail::heap_profile_countdown = std::numeric_limits<std::ptrdiff_t>::max();
+}
+
+void heap_profile_clear() noexcept {
+  sites = {};
+  dropped = 0U;
+}
+
+void heap_profile_dump(profile_writer writer, void* arg) noexcept {
+  const auto base = utils::image_base();
+  char line[32U + DEPTH * 24U];
+  // snprintf returns the untruncated length; keep the last byte for the newline.
+  const auto end_of = [&line](int length, std::size_t at) noexcept {
+    return std::min(at + static_cast<std::size_t>(std::max(length, 0)), sizeof(line) - 1U);
+  };
+  auto n = end_of(std::snprintf(line, sizeof(line),
+                                "heap_profile v1 interval=%zu base=0x%zx dropped=%zu", interval,
+                                static_cast<std::size_t>(base), dropped),
+                  0U);
+  line[n++] = '\n';
+  writer(line, n, arg);
+  for (const auto& site : sites) {
+    if (site.hash == 0U) {
+      continue;
+    }
+    n = end_of(std::snprintf(line, sizeof(line), "%zu %u", site.bytes, site.samples), 0U);
+    for (auto pc : site.pcs) {
+      if (pc == 0U) {
+        break;
+      }
+      n = end_of(std::snprintf(line + n, sizeof(line) - n, " 0x%zx", static_cast<std::size_t>(pc)),
+                 n);
+    }
+    line[n++] = '\n';
+    writer(line, n, arg);
+  }
+}
+
+void heap_profile_dump_fd([[maybe_unused]] int fd) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+  heap_profile_dump(
+      [](const void* data, std::size_t size, void* arg) {
+        const auto fd = *static_cast<int*>(arg);
+        auto p = static_cast<const uint8_t*>(data);
+        while (size != 0U) {
+          const auto n = ::write(fd, p, size);
+          if (n <= 0) {
+            return;
+          }
+          p += n;
+          size -= static_cast<std::size_t>(n);
+        }
+      },
+      &fd);
+#endif
+}
+
+} // namespace allocator
+} // namespace fireball
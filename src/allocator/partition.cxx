@@ -0,0 +1,18 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * partition.cxx - Static RAM block holding every heap partition.
+ */
+#include <allocator/partition.hxx>
+
+namespace fireball {
+namespace allocator {
+
+alignas(FIREBALL_CACHE_LINE_SIZE) uint8_t partition_ram[PARTITION_RAM_SIZE];
+
+} // namespace allocator
+} // namespace fireball
@@ -0,0 +1,27 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * partition_heaps.cxx - Early-boot initialization of the heap partitions.
+ */
+#include <allocator/partition_heaps.hxx>
+#include <allocator/stdcxx_allocator.hxx>
+
+namespace fireball {
+namespace allocator {
+
+void init_partition_heaps() noexcept {
+  coos_kernel_heap::instance().init();
+  wasm_runtime_heap::instance().init();
+  subsystem_heap::instance().init();
+  service_heap::instance().init();
+  guest_heap::instance().init();
+  coroutine_stack_heap::instance().init();
+  stdcxx_allocator::instance().init();
+}
+
+} // namespace allocator
+} // namespace fireball
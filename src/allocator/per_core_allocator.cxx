@@ -0,0 +1,22 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * per_core_allocator.cxx - Core binding of the running hypervisor instance.
+ */
+#include <allocator/current_core.hxx>
+
+namespace fireball {
+namespace allocator {
+
+namespace detail {
+#if FIREBALL_CORE_COUNT > 1
+thread_local uint32_t current_core = 0U;
+#endif
+} // namespace detail
+
+} // namespace allocator
+} // namespace fireball
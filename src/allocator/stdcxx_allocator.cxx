@@ -8,14 +8,24 @@
  * stdcxx_allocator.cxx - Global operator new/delete overrides for C++ standard library.
  *
  * This file implements the global operator new/delete functions to redirect all C++
- * standard library memory allocations to the stdcxx_allocator (specified_allocator).
- * This ensures that all standard library containers and objects use the dedicated
- * host heap partition, enabling fine-grained memory management and isolation from
- * other heap partitions (COOS kernel, WASM runtime, subsystem, service, guest).
+ * standard library memory allocations to the heap of the running COOS task (task_heap).
+ * When no task is running, allocations use the stdcxx_allocator (specified_allocator),
+ * i.e. the dedicated host heap partition. This keeps each guest's churn inside its own
+ * partition, isolated from the host heap and the other heap partitions (COOS kernel,
+ * WASM runtime, subsystem, service, guest).
+ *
+ * Deallocation returns a block to the heap owning its address, which is the current
+ * task heap in the common case, otherwise a registered task heap or the host heap. A block of
+ * a task heap owned by another core is queued on that heap and freed by its owner core, as
+ * the task heaps are not locked. The host heap is shared by all cores and is locked.
+ *
+ * Every allocation and deallocation is passed to alloc_trace(), which records it only when
+ * the build enables FIREBALL_ALLOC_TRACE. operator new also feeds heap_profile_sample()
+ * directly, so the sampled stacks start at the caller of operator new.
  *
  * Error Handling:
- *   - Allocation failures report an error with a backtrace using the
- *     THROW_NESTED_BACKTRACE macro.
+ *   - Allocation failures first print the fragmentation report of the heap that failed,
+ *     then report an error with a backtrace using the THROW_NESTED_BACKTRACE macro.
  *   - When __cpp_exceptions is defined, this throws std::bad_alloc with a nested
  *     exception_with_backtrace.
  *   - When exceptions are disabled, this prints the backtrace and calls std::terminate().
@@ -25,13 +35,86 @@
  *   - All alignment-aware operator new/delete variants properly forward alignment
  *     requirements to the underlying allocator.
  */
+#include <allocator/alloc_trace.hxx>
+#include <allocator/heap_profiler.hxx>
 #include <allocator/stdcxx_allocator.hxx>
+#include <allocator/task_heap.hxx>
+#include <cstdio>
 #include <utils/backtrace.hxx>
+#include <utils/spin_lock.hxx>
+
+namespace {
+
+/**
+ * Serializes the host heap, the only heap all cores allocate from.
+ */
+fireball::utils::spin_lock host_heap_lock;
+
+void* allocate_from_heap(std::size_t num, std::size_t align) noexcept {
+  auto heap = fireball::allocator::current_task_heap();
+  if (heap != nullptr) {
+    heap->drain_remote_frees();
+    return heap->resource->allocate(num, align);
+  }
+  fireball::utils::spin_lock::guard guard(host_heap_lock);
+  return fireball::allocator::stdcxx_allocator::instance().allocate(num, align);
+}
+
+void free_to_heap(void* ptr, std::size_t num, std::size_t align) noexcept {
+  auto heap = fireball::allocator::current_task_heap();
+  if (heap == nullptr || !heap->contains(ptr)) {
+    heap = fireball::allocator::find_task_heap(ptr);
+  }
+  if (heap == nullptr) {
+    fireball::utils::spin_lock::guard guard(host_heap_lock);
+    fireball::allocator::stdcxx_allocator::instance().deallocate(ptr, num, align);
+  } else if (heap->core != fireball::allocator::current_core()) {
+    heap->remote_frees.push(ptr);
+  } else {
+    heap->resource->deallocate(ptr, num, align);
+  }
+}
+
+void* trace_new(void* ptr, std::size_t num, std::size_t align) noexcept {
+  using fireball::allocator::trace_op;
+  fireball::allocator::alloc_trace(ptr != nullptr ? trace_op::alloc : trace_op::alloc_failed,
+                                   num, align, ptr);
+  return ptr;
+}
+
+void trace_delete(void* ptr, std::size_t num, std::size_t align) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  fireball::allocator::alloc_trace(fireball::allocator::trace_op::free, num, align, ptr);
+  free_to_heap(ptr, num, align);
+}
+
+/**
+ * Tell whether the heap that could not serve num bytes is full or fragmented.
+ */
+void report_out_of_memory(std::size_t num) noexcept {
+  std::fprintf(stderr, "operator new: out of memory for %zu bytes\n", num);
+  auto heap = fireball::allocator::current_task_heap();
+  if (heap == nullptr) {
+    fireball::utils::spin_lock::guard guard(host_heap_lock);
+    fireball::allocator::print_frag_report(
+        "stdcxx", fireball::allocator::stdcxx_allocator::instance().fragmentation());
+  } else if (heap->fragmentation != nullptr) {
+    fireball::allocator::print_frag_report("task", heap->fragmentation(*heap->resource));
+  }
+}
+
+constexpr std::size_t DEFAULT_ALIGN = alignof(std::max_align_t);
+
+} // namespace
 
 [[nodiscard]]
 void* operator new(std::size_t num) {
-  auto ret = fireball::allocator::stdcxx_allocator::instance().allocate(num);
+  fireball::allocator::heap_profile_sample(num);
+  auto ret = trace_new(allocate_from_heap(num, DEFAULT_ALIGN), num, DEFAULT_ALIGN);
   if (ret == nullptr) {
+    report_out_of_memory(num);
     THROW_NESTED_BACKTRACE("std::bad_alloc", std::bad_alloc);
   }
 
@@ -40,9 +123,11 @@ void* operator new(std::size_t num) {
 
 [[nodiscard]]
 void* operator new(std::size_t num, std::align_val_t align) {
+  fireball::allocator::heap_profile_sample(num);
   const auto a = static_cast<std::underlying_type<std::align_val_t>::type>(align);
-  auto ret = fireball::allocator::stdcxx_allocator::instance().allocate(num, a);
+  auto ret = trace_new(allocate_from_heap(num, a), num, a);
   if (ret == nullptr) {
+    report_out_of_memory(num);
     THROW_NESTED_BACKTRACE("std::bad_alloc", std::bad_alloc);
   }
 
@@ -51,38 +136,40 @@ void* operator new(std::size_t num, std::align_val_t align) {
 
 [[nodiscard]]
 void* operator new(std::size_t num, const std::nothrow_t&) noexcept {
-  return fireball::allocator::stdcxx_allocator::instance().allocate(num);
+  fireball::allocator::heap_profile_sample(num);
+  return trace_new(allocate_from_heap(num, DEFAULT_ALIGN), num, DEFAULT_ALIGN);
 }
 
 [[nodiscard]]
 void* operator new(std::size_t num, std::align_val_t align, const std::nothrow_t&) noexcept {
+  fireball::allocator::heap_profile_sample(num);
   const auto a = static_cast<std::underlying_type<std::align_val_t>::type>(align);
-  return fireball::allocator::stdcxx_allocator::instance().allocate(num, a);
+  return trace_new(allocate_from_heap(num, a), num, a);
 }
 
 void operator delete(void* ptr) noexcept {
-  fireball::allocator::stdcxx_allocator::instance().deallocate(ptr, 0U);
+  trace_delete(ptr, 0U, DEFAULT_ALIGN);
 }
 
 void operator delete(void* ptr, std::size_t num) noexcept {
-  fireball::allocator::stdcxx_allocator::instance().deallocate(ptr, num);
+  trace_delete(ptr, num, DEFAULT_ALIGN);
 }
 
 void operator delete(void* ptr, std::align_val_t align) noexcept {
   const auto a = static_cast<std::underlying_type<std::align_val_t>::type>(align);
-  fireball::allocator::stdcxx_allocator::instance().deallocate(ptr, 0U, a);
+  trace_delete(ptr, 0U, a);
 }
 
 void operator delete(void* ptr, std::size_t num, std::align_val_t align) noexcept {
   const auto a = static_cast<std::underlying_type<std::align_val_t>::type>(align);
-  fireball::allocator::stdcxx_allocator::instance().deallocate(ptr, num, a);
+  trace_delete(ptr, num, a);
 }
 
 void operator delete(void* ptr, const std::nothrow_t&) noexcept {
-  fireball::allocator::stdcxx_allocator::instance().deallocate(ptr, 0U);
+  trace_delete(ptr, 0U, DEFAULT_ALIGN);
 }
 
 void operator delete(void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept {
   const auto a = static_cast<std::underlying_type<std::align_val_t>::type>(align);
-  fireball::allocator::stdcxx_allocator::instance().deallocate(ptr, 0U, a);
+  trace_delete(ptr, 0U, a);
 }
@@ -0,0 +1,101 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * task_heap.cxx - Current task heap of every core and the registry of task heaps.
+ *
+ * Registered heaps must lie in partition_ram on FIREBALL_PARTITION_GRANULE boundaries. Every
+ * granule remembers the registry slot of the heap covering it, so the owner of an address is
+ * found with one table lookup instead of asking each heap.
+ */
+#include <allocator/partition.hxx>
+#include <allocator/task_heap.hxx>
+#include <array>
+
+namespace fireball {
+namespace allocator {
+
+namespace detail {
+std::array<task_heap*, FIREBALL_CORE_COUNT> current_task_heaps = {};
+} // namespace detail
+
+namespace {
+
+constexpr uint8_t NO_HEAP = 0xFFU;
+
+static_assert(FIREBALL_MAX_TASKS < NO_HEAP, "too many tasks for the granule owner map");
+
+std::array<task_heap*, FIREBALL_MAX_TASKS> task_heaps = {};
+
+constexpr std::array<uint8_t, PARTITION_GRANULES + 1U> make_vacant_owners() {
+  std::array<uint8_t, PARTITION_GRANULES + 1U> ret = {};
+  ret.fill(NO_HEAP);
+  return ret;
+}
+
+// the last entry stands for every address outside partition_ram.
+std::array<uint8_t, PARTITION_GRANULES + 1U> granule_owners = make_vacant_owners();
+
+bool is_granular(const void* p) noexcept {
+  return (reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(partition_ram)) %
+             FIREBALL_PARTITION_GRANULE ==
+         0U;
+}
+
+void assign_granules(const task_heap* heap, uint8_t owner) noexcept {
+  const auto first = partition_granule_of(heap->begin);
+  const auto last = partition_granule_of(heap->end - 1) + 1U;
+  for (auto g = first; g < last; ++g) {
+    granule_owners[g] = owner;
+  }
+}
+
+} // namespace
+
+bool register_task_heap(task_heap* heap) noexcept {
+  if (partition_granule_of(heap->begin) == PARTITION_GRANULES ||
+      partition_granule_of(heap->end - 1) == PARTITION_GRANULES || !is_granular(heap->begin) ||
+      !is_granular(heap->end)) {
+    return false;
+  }
+  task_heap** vacant = nullptr;
+  for (auto& slot : task_heaps) {
+    if (slot == heap) {
+      return true;
+    }
+    if (slot == nullptr && vacant == nullptr) {
+      vacant = &slot;
+    }
+  }
+  if (vacant == nullptr) {
+    return false;
+  }
+  *vacant = heap;
+  assign_granules(heap, static_cast<uint8_t>(vacant - task_heaps.data()));
+  return true;
+}
+
+void unregister_task_heap(task_heap* heap) noexcept {
+  for (auto& slot : task_heaps) {
+    if (slot == heap) {
+      assign_granules(heap, NO_HEAP);
+      slot = nullptr;
+    }
+  }
+  for (auto& current : detail::current_task_heaps) {
+    if (current == heap) {
+      current = nullptr;
+    }
+  }
+}
+
+task_heap* find_task_heap(const void* p) noexcept {
+  const auto owner = granule_owners[partition_granule_of(p)];
+  return owner != NO_HEAP ? task_heaps[owner] : nullptr;
+}
+
+} // namespace allocator
+} // namespace fireball
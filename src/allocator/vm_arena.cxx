@@ -0,0 +1,56 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * vm_arena.cxx - Lazily committed arenas on top of mmap/madvise for the native build.
+ */
+#include <allocator/vm_arena.hxx>
+
+#if FIREBALL_VM_ARENA
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/backtrace.hxx>
+
+namespace fireball {
+namespace allocator {
+
+namespace {
+
+#if defined(MAP_NORESERVE)
+constexpr int RESERVE_FLAGS = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#else
+constexpr int RESERVE_FLAGS = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+
+uintptr_t page_size() noexcept {
+  static const auto size = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+} // namespace
+
+uint8_t* vm_reserve(std::size_t size) noexcept {
+  auto ret = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, RESERVE_FLAGS, -1, 0);
+  if (ret == MAP_FAILED) {
+    utils::report_backtrace_and_terminate("vm_reserve: cannot map the arena");
+  }
+  return static_cast<uint8_t*>(ret);
+}
+
+void vm_release(void* p, std::size_t size) noexcept {
+  const auto mask = page_size() - 1U;
+  const auto first = (reinterpret_cast<uintptr_t>(p) + mask) & ~mask;
+  const auto last = (reinterpret_cast<uintptr_t>(p) + size) & ~mask;
+  if (first < last) {
+    ::madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+  }
+}
+
+} // namespace allocator
+} // namespace fireball
+
+#endif // #if FIREBALL_VM_ARENA
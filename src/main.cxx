@@ -4,8 +4,12 @@
  * Copyright (c) 2025 Takuya Matsunaga.
  */
 #include "commons.hxx"
+#include <allocator/partition_heaps.hxx>
 
 /**
  * entrypont.
  */
-int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) { return 0; }
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  fireball::allocator::init_partition_heaps();
+  return 0;
+}
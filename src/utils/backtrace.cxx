@@ -3,40 +3,273 @@
  *
  * Copyright (c) 2025 Takuya Matsunaga.
  */
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 #include <stacktrace>
+#include <type_traits>
 #include <utils/backtrace.hxx>
+#include <utils/spin_lock.hxx>
+#include <utils/stack_walk.hxx>
+#if FIREBALL_EMERGENCY_HEAP_SIZE != 0
+#include <allocator/specified_allocator.hxx>
+#include <allocator/task_heap.hxx>
+#endif
 
 namespace fireball {
 namespace utils {
 
 namespace {
 
-std::string make_massage(const std::string& msg) {
-  std::ostringstream oss;
-  oss << "message: " << msg << "\n";
-  auto trace = std::stacktrace::current();
-  if (!trace.empty()) {
-    oss << "trace:\n";
-    for (const auto& frame : trace) {
-      oss << "  " << frame << std::endl;
+constexpr std::size_t SYMBOL_SLOTS = FIREBALL_SYMBOL_CACHE_SLOTS;
+constexpr std::size_t SEEN_SLOTS = 32U;
+constexpr std::size_t SYMBOL_TEXT_SIZE = 192U;
+
+static_assert((SYMBOL_SLOTS & (SYMBOL_SLOTS - 1U)) == 0U,
+              "symbol cache slots must be a power of two");
+
+/**
+ * Direct-mapped cache of symbolized addresses. std::stacktrace resolves an address from
+ * scratch every time it is printed; the same frames show up in every report from one site.
+ * The text is kept in place, truncated, as a heap string would dangle once the task heap it
+ * came from is reset.
+ */
+struct symbol_entry {
+  uintptr_t pc;
+  std::array<char, SYMBOL_TEXT_SIZE> text;
+};
+
+std::array<symbol_entry, SYMBOL_SLOTS> symbols;
+
+/**
+ * Stacks described so far, by hash, and how often.
+ */
+struct seen_entry {
+  uint32_t hash;
+  uint32_t count;
+};
+
+std::array<seen_entry, SEEN_SLOTS> seen;
+
+/**
+ * Guards symbols and seen, which every core reports into. Nothing allocates while it is held,
+ * so a failure inside a report cannot come back and wait for it.
+ */
+spin_lock tables_lock;
+
+/**
+ * Write the symbolized text of the return address pc to out.
+ */
+void symbolize(uintptr_t pc, std::ostream& out) {
+  // stacktrace_entry is a wrapper of the address; rebuild one to reuse the library symbolizer.
+  static_assert(sizeof(std::stacktrace_entry) == sizeof(uintptr_t) &&
+                    std::is_trivially_copyable_v<std::stacktrace_entry>,
+                "std::stacktrace_entry is expected to hold only the address");
+  auto& entry = symbols[(pc ^ (pc >> 12U)) & (SYMBOL_SLOTS - 1U)];
+  std::array<char, SYMBOL_TEXT_SIZE> text;
+  {
+    spin_lock::guard guard(tables_lock);
+    text = entry.text;
+    if (entry.pc != pc) {
+      text[0] = '\0';
     }
   }
-  return oss.str();
+  if (text[0] == '\0') {
+    std::ostringstream oss;
+    // a return address points after the call; look up the call instruction itself.
+    oss << std::bit_cast<std::stacktrace_entry>(pc - 1U);
+    const auto str = oss.str();
+    const auto n = std::min(str.size(), text.size() - 1U);
+    std::copy_n(str.data(), n, text.data());
+    text[n] = '\0';
+    spin_lock::guard guard(tables_lock);
+    entry.pc = pc;
+    entry.text = text;
+  }
+  out << text.data();
 }
 
-} // namespace
+/**
+ * Record one more description of the stack with this hash and return how often it has been
+ * described, including this time.
+ */
+uint32_t count_seen(uint32_t hash) noexcept {
+  spin_lock::guard guard(tables_lock);
+  for (std::size_t i = 0U; i < SEEN_SLOTS; ++i) {
+    auto& entry = seen[(hash + i) & (SEEN_SLOTS - 1U)];
+    if (entry.hash == 0U) {
+      entry.hash = hash;
+    } else if (entry.hash != hash) {
+      continue;
+    }
+    return ++entry.count;
+  }
+  // the table is full: describe it in full every time.
+  return 1U;
+}
 
-exception_with_backtrace::exception_with_backtrace(const std::string& msg)
-    : std::runtime_error(make_massage(msg)) {}
+/**
+ * crash_writer - Formatter of the allocation-free report, writing to stderr through a fixed
+ * buffer.
+ */
+class crash_writer {
+public:
+  ~crash_writer() noexcept { flush(); }
 
-void report_backtrace_and_terminate(const char* msg) noexcept {
+  crash_writer& operator<<(const char* s) noexcept {
+    while (*s != '\0') {
+      put(*s++);
+    }
+    return *this;
+  }
+
+  crash_writer& operator<<(uintptr_t value) noexcept {
+    char digits[sizeof(uintptr_t) * 2U];
+    std::size_t n = 0U;
+    do {
+      digits[n++] = "0123456789abcdef"[value & 0xFU];
+      value >>= 4U;
+    } while (value != 0U);
+    put('0');
+    put('x');
+    while (n != 0U) {
+      put(digits[--n]);
+    }
+    return *this;
+  }
+
+private:
+  void put(char c) noexcept {
+    if (size_ == buffer_.size()) {
+      flush();
+    }
+    buffer_[size_++] = c;
+  }
+
+  void flush() noexcept {
+    std::fwrite(buffer_.data(), 1U, size_, stderr);
+    std::fflush(stderr);
+    size_ = 0U;
+  }
+
+  std::array<char, 128U> buffer_;
+  std::size_t size_ = 0U;
+}; // class crash_writer
+
+// static, so that a report never depends on how much stack is left.
+raw_backtrace crash_trace;
+
+/**
+ * Write msg and the raw return addresses of the caller's stack. Neither allocates nor
+ * symbolizes, so it works when the heap is exhausted; tools/symbolize_crash.sh turns the
+ * addresses into source lines.
+ */
+[[gnu::noinline]] void write_raw_backtrace(const char* msg) noexcept {
+  // skip the frame of this function.
+  crash_trace = raw_backtrace::capture(1U);
+  crash_writer out;
+  out << "fatal: " << msg << "\nbacktrace base=" << image_base() << "\n";
+  for (auto pc : crash_trace) {
+    out << "  " << pc << "\n";
+  }
+}
+
+#if FIREBALL_EMERGENCY_HEAP_SIZE != 0
+struct emergency_tag {};
+using emergency_heap = allocator::specified_allocator<FIREBALL_EMERGENCY_HEAP_SIZE, emergency_tag>;
+#endif
+
+/**
+ * Write the symbolized report. The heap that just failed may be the one operator new uses, so
+ * it runs on a reserve heap of its own.
+ */
+void write_symbolized_backtrace([[maybe_unused]] const char* msg) noexcept {
+#if FIREBALL_EMERGENCY_HEAP_SIZE != 0
+  auto heap = allocator::task_heap::of(emergency_heap::instance());
+  allocator::switch_task_heap(&heap);
+#if defined(__cpp_exceptions)
   try {
-    std::cerr << make_massage(msg) << std::endl;
+    std::cerr << "message: " << msg << "\n" << describe_backtrace(crash_trace, true) << std::flush;
   } catch (...) {
     // ignore.
   }
+#else
+  std::cerr << "message: " << msg << "\n" << describe_backtrace(crash_trace, true) << std::flush;
+#endif
+#endif
+}
+
+} // namespace
+
+raw_backtrace raw_backtrace::capture(std::size_t skip) noexcept {
+  raw_backtrace ret;
+  // the first frame is the one of the caller, in this function.
+  ret.size_ = unwind_return_addresses(ret.pcs_.data(), DEPTH, skip + 1U);
+  return ret;
+}
+
+uint32_t raw_backtrace::hash() const noexcept {
+  uint32_t ret = 2166136261U;
+  for (auto pc : *this) {
+    ret = (ret ^ static_cast<uint32_t>(pc ^ (pc >> 16U >> 16U))) * 16777619U;
+  }
+  return ret == 0U ? 1U : ret;
+}
+
+std::string describe_backtrace(const raw_backtrace& trace, bool full) {
+  if (trace.empty()) {
+    return std::string();
+  }
+  const auto hash = trace.hash();
+  const auto count = count_seen(hash);
+  std::ostringstream oss;
+  oss << "trace 0x" << std::hex << hash << std::dec << ":";
+  if (count > 1U) {
+    oss << " seen " << count << " times";
+  }
+  oss << "\n";
+  if (count > 1U && !full) {
+    return oss.str();
+  }
+  for (auto pc : trace) {
+    oss << "  ";
+    symbolize(pc, oss);
+    oss << "\n";
+  }
+  return oss.str();
+}
+
+exception_with_backtrace::exception_with_backtrace(const std::string& msg)
+    : std::runtime_error(msg), backtrace_(raw_backtrace::capture(1U)), what_() {}
+
+const char* exception_with_backtrace::what() const noexcept {
+  if (what_.empty()) {
+#if defined(__cpp_exceptions)
+    try {
+      what_ = "message: " + std::string(std::runtime_error::what()) + "\n" +
+              describe_backtrace(backtrace_);
+    } catch (...) {
+      return std::runtime_error::what();
+    }
+#else
+    what_ = "message: " + std::string(std::runtime_error::what()) + "\n" +
+            describe_backtrace(backtrace_);
+#endif
+  }
+  return what_.c_str();
+}
+
+void report_backtrace_and_terminate(const char* msg) noexcept {
+  // a failure inside the symbolized report comes back here; the raw report is all it gets.
+  static bool symbolizing = false;
+  write_raw_backtrace(msg);
+  if (!symbolizing) {
+    symbolizing = true;
+    write_symbolized_backtrace(msg);
+  }
   std::terminate();
 }
 
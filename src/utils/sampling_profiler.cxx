@@ -0,0 +1,318 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * sampling_profiler.cxx - Timer driven sampling profiler of host and guest call stacks.
+ *
+ * Every tick walks the frame pointers of the interrupted host code, asks the interpreter for
+ * the guest call stack, and counts the pair in a fixed open-addressing table keyed by a hash
+ * of both stacks. Ticks only read stacks and write the table, which keeps them safe in a
+ * signal handler or an interrupt; all formatting is left to sample_profile_dump().
+ */
+#include <utils/sampling_profiler.hxx>
+
+#if FIREBALL_SAMPLE_PROFILE
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <utils/backtrace.hxx>
+#include <utils/stack_walk.hxx>
+#if defined(__linux__)
+#include <csignal>
+#include <pthread.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace fireball {
+namespace utils {
+
+namespace {
+
+constexpr std::size_t HOST_DEPTH = FIREBALL_SAMPLE_PROFILE_DEPTH;
+constexpr std::size_t GUEST_DEPTH = FIREBALL_SAMPLE_PROFILE_GUEST_DEPTH;
+constexpr std::size_t SLOTS = FIREBALL_SAMPLE_PROFILE_SLOTS;
+
+static_assert((SLOTS & (SLOTS - 1U)) == 0U, "sample profile slots must be a power of two");
+static_assert(HOST_DEPTH >= 1U && HOST_DEPTH <= 0xFFU && GUEST_DEPTH <= 0xFFU,
+              "sample profile depth out of range");
+
+/**
+ * One distinct stack; both arrays are innermost first and zero past their depth.
+ */
+struct folded_stack {
+  uint32_t hash;
+  uint32_t samples;
+  uint8_t host_depth;
+  uint8_t guest_depth;
+  std::array<uintptr_t, HOST_DEPTH> host;
+  std::array<uint32_t, GUEST_DEPTH> guest;
+};
+
+std::array<folded_stack, SLOTS> stacks;
+uint32_t dropped = 0U;
+std::atomic<bool> active = false;
+guest_stack_provider guest_provider = nullptr;
+void* guest_arg = nullptr;
+
+/**
+ * Top of the stack of the calling thread, set by sample_profile_attach_thread(); 0 if unknown.
+ */
+thread_local uintptr_t thread_stack_top = 0U;
+
+uint32_t hash_of(const folded_stack& s) noexcept {
+  uint32_t ret = 2166136261U;
+  for (std::size_t i = 0U; i < s.host_depth; ++i) {
+    ret = (ret ^ static_cast<uint32_t>(s.host[i] ^ (s.host[i] >> 16U >> 16U))) * 16777619U;
+  }
+  for (std::size_t i = 0U; i < s.guest_depth; ++i) {
+    ret = (ret ^ s.guest[i] ^ 0x80000000U) * 16777619U;
+  }
+  // 0 marks an empty slot.
+  return ret == 0U ? 1U : ret;
+}
+
+bool same_stack(const folded_stack& a, const folded_stack& b) noexcept {
+  return a.host_depth == b.host_depth && a.guest_depth == b.guest_depth && a.host == b.host &&
+         a.guest == b.guest;
+}
+
+/**
+ * Walk the host frames of the interrupted code. Its frame pointer may hold anything (code built
+ * without frame pointers uses it as a general register), so it is only followed if it is
+ * aligned and its frame record lies between the interrupted sp and the top of the stack.
+ */
+std::size_t interrupted_frames(const void* fp, const void* sp, const void* stack_top,
+                               uintptr_t* out, std::size_t max) noexcept {
+  constexpr auto RECORD = 2U * sizeof(uintptr_t);
+  const auto frame = reinterpret_cast<uintptr_t>(fp);
+#if defined(__riscv)
+  // the frame record lies below the frame pointer.
+  const auto record = frame - RECORD;
+#else
+  const auto record = frame;
+#endif
+  const auto low = reinterpret_cast<uintptr_t>(sp);
+  const auto high = reinterpret_cast<uintptr_t>(stack_top);
+  if ((frame & (sizeof(uintptr_t) - 1U)) != 0U || record < low || record >= high ||
+      high - record < RECORD) {
+    return 0U;
+  }
+  return walk_frame_pointers(fp, out, max, 0U, high);
+}
+
+#if defined(__linux__)
+void on_sigprof(int, siginfo_t*, void* context) noexcept {
+  [[maybe_unused]] const auto uc = static_cast<const ucontext_t*>(context);
+  [[maybe_unused]] const auto top = reinterpret_cast<const void*>(thread_stack_top);
+#if defined(__x86_64__)
+  sample_profile_tick(static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RIP]),
+                      reinterpret_cast<const void*>(uc->uc_mcontext.gregs[REG_RBP]),
+                      reinterpret_cast<const void*>(uc->uc_mcontext.gregs[REG_RSP]), top);
+#elif defined(__aarch64__)
+  sample_profile_tick(static_cast<uintptr_t>(uc->uc_mcontext.pc),
+                      reinterpret_cast<const void*>(uc->uc_mcontext.regs[29]),
+                      reinterpret_cast<const void*>(uc->uc_mcontext.sp), top);
+#else
+  // nothing.
+#endif
+}
+
+bool arm_timer(uint32_t hz) noexcept {
+  if (hz != 0U) {
+    struct sigaction action = {};
+    action.sa_sigaction = on_sigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+      return false;
+    }
+  }
+  itimerval timer = {};
+  if (hz != 0U) {
+    const auto usec = hz >= 1000000U ? 1U : 1000000U / hz;
+    timer.it_interval.tv_sec = static_cast<time_t>(usec / 1000000U);
+    timer.it_interval.tv_usec = static_cast<suseconds_t>(usec % 1000000U);
+    timer.it_value = timer.it_interval;
+  }
+  return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+}
+#else
+bool arm_timer([[maybe_unused]] uint32_t hz) noexcept { return true; }
+#endif
+
+} // namespace
+
+void sample_profile_tick(uintptr_t pc, const void* fp, const void* sp,
+                         const void* stack_top) noexcept {
+  if (!active.load(std::memory_order_relaxed)) {
+    return;
+  }
+  folded_stack sample = {};
+  sample.host[0] = pc;
+  sample.host_depth = static_cast<uint8_t>(
+      1U + interrupted_frames(fp, sp, stack_top, sample.host.data() + 1U, HOST_DEPTH - 1U));
+  if (guest_provider != nullptr) {
+    sample.guest_depth =
+        static_cast<uint8_t>(guest_provider(sample.guest.data(), GUEST_DEPTH, guest_arg));
+  }
+  const auto hash = hash_of(sample);
+  for (std::size_t i = 0U; i < SLOTS; ++i) {
+    auto& entry = stacks[(hash + i) & (SLOTS - 1U)];
+    if (entry.hash == 0U) {
+      entry = sample;
+      entry.hash = hash;
+    } else if (entry.hash != hash || !same_stack(entry, sample)) {
+      continue;
+    }
+    ++entry.samples;
+    return;
+  }
+  ++dropped;
+}
+
+bool sample_profile_attach_thread() noexcept {
+#if defined(__linux__)
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+    return false;
+  }
+  void* low = nullptr;
+  std::size_t size = 0U;
+  const auto ok = pthread_attr_getstack(&attr, &low, &size) == 0;
+  pthread_attr_destroy(&attr);
+  if (ok) {
+    thread_stack_top = reinterpret_cast<uintptr_t>(low) + size;
+  }
+  return ok;
+#else
+  return false;
+#endif
+}
+
+bool sample_profile_start(uint32_t hz) noexcept {
+  sample_profile_attach_thread();
+  active.store(true, std::memory_order_relaxed);
+  if (!arm_timer(hz)) {
+    active.store(false, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void sample_profile_stop() noexcept {
+  arm_timer(0U);
+  active.store(false, std::memory_order_relaxed);
+}
+
+void sample_profile_clear() noexcept {
+  ASSERT_WITH_BACKTRACE(!active.load(std::memory_order_relaxed));
+  stacks = {};
+  dropped = 0U;
+}
+
+void sample_profile_set_guest_stack(guest_stack_provider provider, void* arg) noexcept {
+  guest_arg = arg;
+  guest_provider = provider;
+}
+
+void sample_profile_dump(sample_writer writer, void* arg) noexcept {
+  ASSERT_WITH_BACKTRACE(!active.load(std::memory_order_relaxed));
+  const auto base = image_base();
+  char line[32U + HOST_DEPTH * 20U + GUEST_DEPTH * 16U];
+  for (const auto& entry : stacks) {
+    if (entry.hash == 0U) {
+      continue;
+    }
+    std::size_t n = 0U;
+    for (auto i = entry.guest_depth; i != 0U; --i) {
+      n += static_cast<std::size_t>(std::snprintf(line + n, sizeof(line) - n, "wasm:%u;",
+                                                  static_cast<unsigned>(entry.guest[i - 1U])));
+    }
+    for (auto i = entry.host_depth; i != 0U; --i) {
+      // return addresses point after the call; name the call instruction itself.
+      const auto pc = entry.host[i - 1U] - base - (i == 1U ? 0U : 1U);
+      n += static_cast<std::size_t>(
+          std::snprintf(line + n, sizeof(line) - n, "0x%zx;", static_cast<std::size_t>(pc)));
+    }
+    // the count replaces the ';' after the innermost frame.
+    n = n - 1U + static_cast<std::size_t>(std::snprintf(line + n - 1U, sizeof(line) - n + 1U,
+                                                        " %u\n", entry.samples));
+    writer(line, n, arg);
+  }
+  if (dropped != 0U) {
+    const auto n = std::snprintf(line, sizeof(line), "[dropped] %u\n", dropped);
+    writer(line, static_cast<std::size_t>(n), arg);
+  }
+}
+
+void sample_profile_dump_fd([[maybe_unused]] int fd) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+  sample_profile_dump(
+      [](const void* data, std::size_t size, void* arg) {
+        const auto fd = *static_cast<int*>(arg);
+        auto p = static_cast<const uint8_t*>(data);
+        while (size != 0U) {
+          const auto n = ::write(fd, p, size);
+          if (n <= 0) {
+            return;
+          }
+          p += n;
+          size -= static_cast<std::size_t>(n);
+        }
+      },
+      &fd);
+#endif
+}
+
+} // namespace utils
+} // namespace fireball
+
+#else
+
+namespace fireball {
+namespace utils {
+
+void sample_profile_tick([[maybe_unused]] uintptr_t pc, [[maybe_unused]] const void* fp,
+                         [[maybe_unused]] const void* sp,
+                         [[maybe_unused]] const void* stack_top) noexcept {
+  // nothing.
+}
+
+bool sample_profile_attach_thread() noexcept { return false; }
+
+bool sample_profile_start([[maybe_unused]] uint32_t hz) noexcept { return false; }
+
+void sample_profile_stop() noexcept {
+  // nothing.
+}
+
+void sample_profile_clear() noexcept {
+  // nothing.
+}
+
+void sample_profile_set_guest_stack([[maybe_unused]] guest_stack_provider provider,
+                                    [[maybe_unused]] void* arg) noexcept {
+  // nothing.
+}
+
+void sample_profile_dump([[maybe_unused]] sample_writer writer,
+                         [[maybe_unused]] void* arg) noexcept {
+  // nothing.
+}
+
+void sample_profile_dump_fd([[maybe_unused]] int fd) noexcept {
+  // nothing.
+}
+
+} // namespace utils
+} // namespace fireball
+
+#endif // #if FIREBALL_SAMPLE_PROFILE
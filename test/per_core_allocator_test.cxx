@@ -0,0 +1,174 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * per_core_allocator_test.cxx - Blocks freed by a foreign core go back to their owner.
+ *
+ * Core 0 allocates blocks and hands them to core 1 through a ring, core 1 frees them, and they
+ * travel back through the remote free queue of core 0. Each core runs in its own thread, as
+ * the hypervisor instances of two cores would. The threads are plain pthreads: std::thread
+ * allocates its state with operator new, which the test would then have to route to a heap.
+ */
+#include "test_common.hxx"
+#include <allocator/partition_heaps.hxx>
+#include <allocator/per_core_allocator.hxx>
+#include <allocator/task_heap.hxx>
+#include <array>
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+using namespace fireball;
+using namespace fireball::allocator;
+
+constexpr uint32_t ARENA_SIZE = 64U * 1024U;
+constexpr std::size_t BLOCKS = 100000U;
+constexpr std::size_t RING_SIZE = 64U;
+constexpr std::size_t BLOCK = 48U;
+
+struct test_tag {};
+using heap = per_core_allocator<ARENA_SIZE, test_tag, 2U>;
+
+/**
+ * Single-producer single-consumer ring handing blocks from core 0 to core 1.
+ */
+std::array<std::atomic<void*>, RING_SIZE> ring = {};
+
+std::atomic<std::size_t> failures = 0U;
+std::size_t frees = 0U;
+
+void* produce(void*) noexcept {
+  bind_current_core(0U);
+  std::size_t produced = 0U;
+  for (std::size_t i = 0U; i < BLOCKS; ++i) {
+    auto p = heap::instance().allocate(BLOCK);
+    if (p == nullptr) {
+      failures.fetch_add(1U, std::memory_order_relaxed);
+      continue;
+    }
+    auto& slot = ring[produced++ % RING_SIZE];
+    while (slot.load(std::memory_order_acquire) != nullptr) {
+      sched_yield();
+    }
+    slot.store(p, std::memory_order_release);
+  }
+  return nullptr;
+}
+
+void* consume(void*) noexcept {
+  bind_current_core(1U);
+  for (std::size_t i = 0U; frees + failures.load(std::memory_order_relaxed) < BLOCKS; ++i) {
+    auto& slot = ring[i % RING_SIZE];
+    void* p;
+    while ((p = slot.exchange(nullptr, std::memory_order_acquire)) == nullptr) {
+      if (frees + failures.load(std::memory_order_relaxed) >= BLOCKS) {
+        return nullptr;
+      }
+      sched_yield();
+    }
+    heap::instance().deallocate(p, BLOCK);
+    ++frees;
+  }
+  return nullptr;
+}
+
+void* current_heap(void* core) noexcept {
+  bind_current_core(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(core)));
+  return current_task_heap();
+}
+
+/**
+ * Current task heap of core, as seen from a thread bound to it.
+ */
+task_heap* current_heap_of(uint32_t core) noexcept {
+  pthread_t thread;
+  void* ret = nullptr;
+  const auto arg = reinterpret_cast<void*>(uintptr_t{core});
+  if (pthread_create(&thread, nullptr, current_heap, arg) != 0) {
+    EXPECT(false);
+    return nullptr;
+  }
+  EXPECT(pthread_join(thread, &ret) == 0);
+  return static_cast<task_heap*>(ret);
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  static_assert(FIREBALL_CORE_COUNT >= 2U, "the test needs two cores (meson option core_count)");
+
+  // the current task heap is per core.
+  auto task = task_heap::of(heap::core_heap<0U>::instance());
+  bind_current_core(0U);
+  switch_task_heap(&task);
+  EXPECT(current_task_heap() == &task);
+  EXPECT(current_heap_of(0U) == &task);
+  EXPECT(current_heap_of(1U) == nullptr);
+  switch_task_heap(nullptr);
+
+  // remote frees under contention.
+  pthread_t producer;
+  pthread_t consumer;
+  const auto consumer_started = pthread_create(&consumer, nullptr, consume, nullptr) == 0;
+  const auto producer_started =
+      consumer_started && pthread_create(&producer, nullptr, produce, nullptr) == 0;
+  EXPECT(consumer_started);
+  EXPECT(producer_started);
+  if (producer_started) {
+    EXPECT(pthread_join(producer, nullptr) == 0);
+  } else {
+    // no blocks will come: let the consumer give up.
+    failures.fetch_add(BLOCKS, std::memory_order_relaxed);
+  }
+  if (consumer_started) {
+    EXPECT(pthread_join(consumer, nullptr) == 0);
+  } else {
+    // nothing.
+  }
+  EXPECT(failures.load() == 0U);
+  EXPECT(frees == BLOCKS);
+  EXPECT(heap::core_heap<1U>::instance().used() == 0U);
+
+  // the next allocation on core 0 drains its queue.
+  bind_current_core(0U);
+  heap::instance().deallocate(heap::instance().allocate(BLOCK), BLOCK);
+  EXPECT(heap::core_heap<0U>::instance().used() == 0U);
+
+  // per-core arenas of a partition tag are consecutive slices of the partition.
+  using guest_cores = per_core_allocator<partition_size_v<partition_id::guest> / 2U,
+                                         partition_heap_tag<partition_id::guest>, 2U>;
+  auto& guest0 = guest_cores::core_heap<0U>::instance();
+
+  // operator delete on a foreign core leaves the block to the core owning its task heap.
+  auto guest = task_heap::of(guest0);
+  EXPECT(register_task_heap(&guest));
+  switch_task_heap(&guest);
+  auto block = ::operator new(BLOCK);
+  EXPECT(guest.contains(block));
+  switch_task_heap(nullptr);
+  const auto used = guest0.used();
+  bind_current_core(1U);
+  ::operator delete(block, BLOCK);
+  EXPECT(guest0.used() == used);
+  bind_current_core(0U);
+  switch_task_heap(&guest);
+  ::operator delete(::operator new(BLOCK), BLOCK);
+  switch_task_heap(nullptr);
+  EXPECT(guest0.used() == 0U);
+  unregister_task_heap(&guest);
+
+  const auto core0 = guest_cores::core_heap<0U>::instance().begin();
+  const auto core1 = guest_cores::core_heap<1U>::instance().begin();
+  EXPECT(partition_of(core0) == partition_id::guest);
+  EXPECT(partition_of(core1) == partition_id::guest);
+  EXPECT(core1 == guest_cores::core_heap<0U>::instance().end());
+  return fireball::test::result();
+}
@@ -0,0 +1,99 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * specified_allocator_test.cxx - The slab front-end holds at least as many small objects as the
+ * bare mspace of the same arena, and gives its pages back once they are empty.
+ */
+#include "test_common.hxx"
+#include <allocator/specified_allocator.hxx>
+#include <array>
+#include <cstdint>
+
+namespace {
+
+using namespace fireball;
+
+constexpr uint32_t ARENA_SIZE = 4U * 1024U;
+constexpr std::size_t MAX_OBJECTS = ARENA_SIZE / 16U;
+
+struct test_tag {};
+using heap = allocator::specified_allocator<ARENA_SIZE, test_tag>;
+
+alignas(std::max_align_t) uint8_t baseline_arena[ARENA_SIZE];
+std::array<void*, MAX_OBJECTS> objects;
+
+/**
+ * Size of the i-th object: 48 bytes, or 16 to 64 bytes in turn.
+ */
+std::size_t size_of(std::size_t i, bool mixed) noexcept {
+  return mixed ? 16U * (1U + (i * 7U) % 4U) : 48U;
+}
+
+/**
+ * Number of objects the bare mspace of an equally sized arena holds.
+ */
+std::size_t baseline_capacity(bool mixed) noexcept {
+  auto msp = create_mspace_with_base(baseline_arena, ARENA_SIZE, 0);
+  std::size_t n = 0U;
+  while (n < MAX_OBJECTS && mspace_memalign(msp, 16U, size_of(n, mixed)) != nullptr) {
+    ++n;
+  }
+  destroy_mspace(msp);
+  return n;
+}
+
+/**
+ * Fill the heap until it fails, then free everything. Returns the number of objects it held.
+ */
+std::size_t heap_capacity(bool mixed) noexcept {
+  auto& h = heap::instance();
+  std::size_t n = 0U;
+  while (n < MAX_OBJECTS && (objects[n] = h.allocate(size_of(n, mixed), 16U)) != nullptr) {
+    ++n;
+  }
+  for (std::size_t i = 0U; i < n; ++i) {
+    h.deallocate(objects[i], size_of(i, mixed), 16U);
+  }
+  return n;
+}
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  auto& h = heap::instance();
+  h.init();
+
+  for (const bool mixed : {true, false}) {
+    const auto baseline = baseline_capacity(mixed);
+    const auto slab = heap_capacity(mixed);
+    EXPECT(baseline > 0U);
+    EXPECT(slab >= baseline);
+    EXPECT(h.used() == 0U);
+
+    // the empty pages went back to the mspace: a block of half the arena fits again.
+    auto large = h.allocate(ARENA_SIZE / 2U);
+    EXPECT(large != nullptr);
+    h.deallocate(large, ARENA_SIZE / 2U);
+
+    // and so does the same number of small objects.
+    EXPECT(heap_capacity(mixed) == slab);
+  }
+
+  // unsized frees find slab objects and mspace fallbacks alike.
+  std::size_t n = 0U;
+  while (n < MAX_OBJECTS && (objects[n] = h.allocate(32U)) != nullptr) {
+    ++n;
+  }
+  for (std::size_t i = 0U; i < n; ++i) {
+    h.deallocate(objects[i], 0U);
+  }
+  EXPECT(h.used() == 0U);
+  return fireball::test::result();
+}
@@ -0,0 +1,46 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+#ifndef FIREBALL_TEST_TEST_COMMON_HXX
+#define FIREBALL_TEST_TEST_COMMON_HXX
+
+#include <commons.hxx>
+#include <cstdio>
+
+namespace fireball {
+namespace test {
+
+/**
+ * Number of failed EXPECT()s so far.
+ */
+inline int failures = 0;
+
+inline void expect(bool ok, const char* expr, const char* file, int line) noexcept {
+  if (!ok) {
+    std::fprintf(stderr, "%s:%d: expected %s\n", file, line, expr);
+    ++failures;
+  }
+}
+
+/**
+ * Exit status of the test program: 0 if every EXPECT() held.
+ */
+inline int result() noexcept {
+  if (failures != 0) {
+    std::fprintf(stderr, "%d failure(s)\n", failures);
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace test
+} // namespace fireball
+
+/**
+ * Record a failure with its location if cond is false; the test goes on.
+ */
+#define EXPECT(cond) ::fireball::test::expect((cond), #cond, __FILE__, __LINE__)
+
+#endif // #ifndef FIREBALL_TEST_TEST_COMMON_HXX
@@ -0,0 +1,50 @@
+/**
+ * The Fireball is Wasm Hypervisor.
+ *
+ * Copyright (c) 2025 Takuya Matsunaga.
+ */
+
+/**
+ * tlsf_allocator_test.cxx - Requests that cannot fit the TLSF arena fail instead of wrapping.
+ */
+#include "test_common.hxx"
+#include <allocator/tlsf_allocator.hxx>
+#include <cstdint>
+
+namespace {
+
+using namespace fireball;
+
+constexpr uint32_t ARENA_SIZE = 64U * 1024U;
+
+struct test_tag {};
+using heap = allocator::tlsf_allocator<ARENA_SIZE, test_tag>;
+
+} // namespace
+
+/**
+ * entrypont.
+ */
+int main([[maybe_unused]] int argc, [[maybe_unused]] char const** argv) {
+  auto& h = heap::instance();
+
+  // sizes whose rounding or header arithmetic wraps around.
+  EXPECT(h.allocate(SIZE_MAX) == nullptr);
+  EXPECT(h.allocate(SIZE_MAX - 8U) == nullptr);
+  EXPECT(h.allocate(SIZE_MAX / 2U + 1U) == nullptr);
+  EXPECT(h.allocate(ARENA_SIZE + 1U) == nullptr);
+  EXPECT(h.allocate(ARENA_SIZE) == nullptr);
+
+  // aligned requests go through take_aligned().
+  EXPECT(h.allocate(SIZE_MAX - 8U, 64U) == nullptr);
+  EXPECT(h.allocate(16U, std::size_t{1U} << (sizeof(std::size_t) * 8U - 1U)) == nullptr);
+
+  // the heap still serves ordinary requests afterwards.
+  auto p = h.allocate(1024U);
+  auto q = h.allocate(1024U, 256U);
+  EXPECT(p != nullptr);
+  EXPECT(q != nullptr && reinterpret_cast<uintptr_t>(q) % 256U == 0U);
+  h.deallocate(q, 1024U, 256U);
+  h.deallocate(p, 1024U);
+  return fireball::test::result();
+}
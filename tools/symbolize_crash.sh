@@ -0,0 +1,23 @@
+#!/bin/bash
+# Symbolize the raw backtrace of a crash or OOM report (report_backtrace_and_terminate())
+
+set -e
+
+REPORT="${1:?usage: $0 <report> [binary]}"
+BINARY="${2:-./builddir/fireball}"
+ADDR2LINE="${ADDR2LINE:-addr2line}"
+
+if [ ! -f "$BINARY" ]; then
+  echo "ERROR: Binary not found: $BINARY"
+  exit 1
+fi
+
+# Addresses are absolute; subtract the load address of a PIE host binary (0 on the MCU).
+BASE=$(sed -n 's/^backtrace base=\(0x[0-9a-fA-F]*\).*/\1/p' "$REPORT" | head -1)
+BASE=$((${BASE:-0}))
+
+grep '^fatal: ' "$REPORT" | head -1
+sed -n '/^backtrace base=/,/^[^ ]/p' "$REPORT" | grep '^  0x' | while read -r PC; do
+  # a return address points after the call; look up the call instruction itself.
+  printf '0x%x\n' $((PC - BASE - 1))
+done | "$ADDR2LINE" -f -C -p -e "$BINARY" | sed 's/^/    /'
@@ -0,0 +1,39 @@
+#!/bin/bash
+# Replace the host addresses of a folded profile (sample_profile_dump()) with function names
+#   tools/symbolize_folded.sh profile.folded builddir/fireball | flamegraph.pl > profile.svg
+
+set -e
+
+PROFILE="${1:?usage: $0 <profile> [binary]}"
+BINARY="${2:-./builddir/fireball}"
+ADDR2LINE="${ADDR2LINE:-addr2line}"
+
+if [ ! -f "$BINARY" ]; then
+  echo "ERROR: Binary not found: $BINARY" >&2
+  exit 1
+fi
+
+# Addresses are already relative to the image base and point at the call instruction.
+SYMBOLS=$(mktemp)
+trap 'rm -f "$SYMBOLS"' EXIT
+ADDRS=$(grep -ao '0x[0-9a-f]*' "$PROFILE" | sort -u)
+if [ -n "$ADDRS" ]; then
+  paste <(echo "$ADDRS") \
+    <(echo "$ADDRS" | "$ADDR2LINE" -f -C -e "$BINARY" | sed -n 'p;n' | tr -d ';') > "$SYMBOLS"
+fi
+
+# Stacks that differ only in addresses within the same functions are merged.
+awk -F '\t' 'NR == FNR { name[$1] = $2; next }
+     {
+       count = $0; sub(/.* /, "", count)
+       stack = $0; sub(/ [0-9]+$/, "", stack)
+       n = split(stack, frames, ";")
+       out = ""
+       for (i = 1; i <= n; i++) {
+         f = frames[i]
+         if (f in name && name[f] != "??") f = name[f]
+         out = out (i > 1 ? ";" : "") f
+       }
+       total[out] += count
+     }
+     END { for (s in total) print s, total[s] }' "$SYMBOLS" "$PROFILE"
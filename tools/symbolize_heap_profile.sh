@@ -0,0 +1,26 @@
+#!/bin/bash
+# Symbolize a heap profile dumped by heap_profile_dump()
+
+set -e
+
+PROFILE="${1:?usage: $0 <profile> [binary]}"
+BINARY="${2:-./builddir/fireball}"
+ADDR2LINE="${ADDR2LINE:-addr2line}"
+
+if [ ! -f "$BINARY" ]; then
+  echo "ERROR: Binary not found: $BINARY"
+  exit 1
+fi
+
+# Addresses are absolute; subtract the load address of a PIE host binary (0 on the MCU).
+BASE=$(head -1 "$PROFILE" | sed -n 's/.*base=\(0x[0-9a-fA-F]*\).*/\1/p')
+BASE=$((${BASE:-0}))
+
+head -1 "$PROFILE"
+tail -n +2 "$PROFILE" | sort -k1,1nr | while read -r BYTES SAMPLES PCS; do
+  echo "$BYTES bytes, $SAMPLES samples"
+  for PC in $PCS; do
+    # a return address points after the call; look up the call instruction itself.
+    printf '0x%x\n' $((PC - BASE - 1))
+  done | "$ADDR2LINE" -f -C -p -e "$BINARY" | sed 's/^/    /'
+done